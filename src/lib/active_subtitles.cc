@@ -51,9 +51,14 @@ ActiveSubtitles::get_burnt (DCPTime time, bool always_burn_subtitles) const
 			continue;
 		}
 
-		BOOST_FOREACH (Period j, i->second) {
-			if (j.from <= time && (!j.to || j.to.get() > time)) {
-				ps.push_back (j.subs);
+		/* Only periods which start by `time' can be active.  Of those, any which finished
+		   before the last clear_before() have gone, so we only look at ones which are active
+		   or which have finished since then.
+		*/
+		Periods::const_iterator const end = i->second.periods.upper_bound (time);
+		for (Periods::const_iterator j = i->second.periods.begin(); j != end; ++j) {
+			if (!j->second.to || j->second.to.get() > time) {
+				ps.push_back (j->second.subs);
 			}
 		}
 	}
@@ -67,19 +72,20 @@ ActiveSubtitles::get_burnt (DCPTime time, bool always_burn_subtitles) const
 void
 ActiveSubtitles::clear_before (DCPTime time)
 {
-	Map updated;
-	for (Map::const_iterator i = _data.begin(); i != _data.end(); ++i) {
-		list<Period> as;
-		BOOST_FOREACH (Period j, i->second) {
-			if (!j.to || j.to.get() >= time) {
-				as.push_back (j);
-			}
+	Ends::iterator const end = _ends.lower_bound (time);
+	for (Ends::iterator i = _ends.begin(); i != end; ++i) {
+		Map::iterator j = _data.find (i->second.first);
+		DCPOMATIC_ASSERT (j != _data.end ());
+		if (j->second.last == i->second.second) {
+			j->second.last = j->second.periods.end ();
 		}
-		if (!as.empty ()) {
-			updated[i->first] = as;
+		j->second.periods.erase (i->second.second);
+		if (j->second.periods.empty ()) {
+			_data.erase (j);
 		}
 	}
-	_data = updated;
+
+	_ends.erase (_ends.begin(), end);
 }
 
 /** Add a new subtitle with a from time.
@@ -90,10 +96,12 @@ ActiveSubtitles::clear_before (DCPTime time)
 void
 ActiveSubtitles::add_from (weak_ptr<Piece> piece, PlayerSubtitles ps, DCPTime from)
 {
-	if (_data.find(piece) == _data.end()) {
-		_data[piece] = list<Period>();
+	Map::iterator i = _data.find (piece);
+	if (i == _data.end ()) {
+		i = _data.insert (make_pair (piece, PiecePeriods ())).first;
 	}
-	_data[piece].push_back (Period (ps, from));
+
+	i->second.last = i->second.periods.insert (make_pair (from, Period (ps, from)));
 }
 
 /** Add the to time for the last subtitle added from a piece.
@@ -104,15 +112,30 @@ ActiveSubtitles::add_from (weak_ptr<Piece> piece, PlayerSubtitles ps, DCPTime fr
 pair<PlayerSubtitles, DCPTime>
 ActiveSubtitles::add_to (weak_ptr<Piece> piece, DCPTime to)
 {
-	DCPOMATIC_ASSERT (_data.find(piece) != _data.end());
+	Map::iterator i = _data.find (piece);
+	DCPOMATIC_ASSERT (i != _data.end() && i->second.last != i->second.periods.end());
+
+	Periods::iterator last = i->second.last;
+
+	if (last->second.to) {
+		/* Forget the old to time */
+		pair<Ends::iterator, Ends::iterator> r = _ends.equal_range (last->second.to.get());
+		for (Ends::iterator j = r.first; j != r.second; ++j) {
+			if (j->second.second == last) {
+				_ends.erase (j);
+				break;
+			}
+		}
+	}
 
-	_data[piece].back().to = to;
+	last->second.to = to;
+	_ends.insert (make_pair (to, make_pair (piece, last)));
 
-	BOOST_FOREACH (SubtitleString& i, _data[piece].back().subs.text) {
-		i.set_out (dcp::Time(to.seconds(), 1000));
+	BOOST_FOREACH (SubtitleString& j, last->second.subs.text) {
+		j.set_out (dcp::Time(to.seconds(), 1000));
 	}
 
-	return make_pair (_data[piece].back().subs, _data[piece].back().from);
+	return make_pair (last->second.subs, last->second.from);
 }
 
 /** @param piece A piece.
@@ -126,11 +149,12 @@ ActiveSubtitles::have (weak_ptr<Piece> piece) const
 		return false;
 	}
 
-	return !i->second.empty();
+	return !i->second.periods.empty();
 }
 
 void
 ActiveSubtitles::clear ()
 {
 	_data.clear ();
+	_ends.clear ();
 }
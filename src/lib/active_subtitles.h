@@ -32,6 +32,9 @@ class Piece;
 
 /** @class ActiveSubtitles
  *  @brief A class to maintain information on active subtitles for Player.
+ *
+ *  Subtitles are kept in order of their start time, and also indexed by their
+ *  end time so that clear_before() only has to look at the ones that it removes.
  */
 class ActiveSubtitles : public boost::noncopyable
 {
@@ -59,7 +62,22 @@ private:
 		boost::optional<DCPTime> to;
 	};
 
-	typedef std::map<boost::weak_ptr<Piece>, std::list<Period> > Map;
+	/** Periods from one piece, keyed on their from time */
+	typedef std::multimap<DCPTime, Period> Periods;
+
+	class PiecePeriods
+	{
+	public:
+		Periods periods;
+		/** The period that was most recently given to add_from, or periods.end() if it has been cleared */
+		Periods::iterator last;
+	};
+
+	typedef std::map<boost::weak_ptr<Piece>, PiecePeriods> Map;
 
 	Map _data;
+
+	/** Periods which have a to time, keyed on that time, with the piece that they are from */
+	typedef std::multimap<DCPTime, std::pair<boost::weak_ptr<Piece>, Periods::iterator> > Ends;
+	Ends _ends;
 };
@@ -0,0 +1,78 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "audio_accumulator.h"
+#include "audio_buffers.h"
+#include "dcpomatic_assert.h"
+
+using std::min;
+using std::list;
+using boost::shared_ptr;
+
+/** @param channels Number of channels of audio that will be pushed.
+ *  @param block_frames Number of frames in each block that we give back.
+ */
+AudioAccumulator::AudioAccumulator (int channels, int32_t block_frames)
+	: _channels (channels)
+	, _block_frames (block_frames)
+{
+	DCPOMATIC_ASSERT (_block_frames > 0);
+}
+
+/** Add some audio.
+ *  @return Any blocks which are now complete.
+ */
+list<shared_ptr<const AudioBuffers> >
+AudioAccumulator::push (shared_ptr<const AudioBuffers> audio)
+{
+	DCPOMATIC_ASSERT (audio->channels() == _channels);
+
+	list<shared_ptr<const AudioBuffers> > out;
+
+	int32_t offset = 0;
+	while (offset < audio->frames ()) {
+		if (!_pending) {
+			_pending.reset (new AudioBuffers (_channels, _block_frames));
+			_pending->set_frames (0);
+		}
+
+		int32_t const have = _pending->frames ();
+		int32_t const to_do = min (audio->frames() - offset, _block_frames - have);
+		_pending->set_frames (have + to_do);
+		_pending->copy_from (audio.get(), to_do, offset, have);
+		offset += to_do;
+
+		if (_pending->frames() == _block_frames) {
+			out.push_back (_pending);
+			_pending.reset ();
+		}
+	}
+
+	return out;
+}
+
+/** @return Any audio that has been pushed but not yet returned in a block, or 0 */
+shared_ptr<const AudioBuffers>
+AudioAccumulator::flush ()
+{
+	shared_ptr<const AudioBuffers> p = _pending;
+	_pending.reset ();
+	return p;
+}
@@ -0,0 +1,49 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DCPOMATIC_AUDIO_ACCUMULATOR_H
+#define DCPOMATIC_AUDIO_ACCUMULATOR_H
+
+#include <boost/shared_ptr.hpp>
+#include <list>
+#include <stdint.h>
+
+class AudioBuffers;
+
+/** @class AudioAccumulator
+ *  @brief Collect audio which arrives in small pieces into larger blocks
+ *  of a fixed size.
+ */
+class AudioAccumulator
+{
+public:
+	AudioAccumulator (int channels, int32_t block_frames);
+
+	std::list<boost::shared_ptr<const AudioBuffers> > push (boost::shared_ptr<const AudioBuffers> audio);
+	boost::shared_ptr<const AudioBuffers> flush ();
+
+private:
+	int _channels;
+	int32_t _block_frames;
+	/** the block that we are currently filling, or 0 */
+	boost::shared_ptr<AudioBuffers> _pending;
+};
+
+#endif
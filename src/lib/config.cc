@@ -53,6 +53,7 @@ using std::ifstream;
 using std::string;
 using std::list;
 using std::max;
+using std::min;
 using std::remove;
 using std::exception;
 using std::cerr;
@@ -109,6 +110,11 @@ Config::set_defaults ()
 	_check_for_test_updates = false;
 	_maximum_j2k_bandwidth = 250000000;
 	_log_types = LogEntry::TYPE_GENERAL | LogEntry::TYPE_WARNING | LogEntry::TYPE_ERROR;
+	_sound_write_block = 48000;
+	/* A few threads per image speeds up scaling in the viewer a lot; more than that
+	   gives little extra, and an encode is already using the other cores.
+	*/
+	_scale_threads = min (4U, max (1U, boost::thread::hardware_concurrency ()));
 	_analyse_ebur128 = true;
 	_automatic_audio_analysis = false;
 #ifdef DCPOMATIC_WINDOWS
@@ -281,6 +287,12 @@ try
 	_allow_any_dcp_frame_rate = f.optional_bool_child ("AllowAnyDCPFrameRate").get_value_or (false);
 
 	_log_types = f.optional_number_child<int> ("LogTypes").get_value_or (LogEntry::TYPE_GENERAL | LogEntry::TYPE_WARNING | LogEntry::TYPE_ERROR);
+	_sound_write_block = f.optional_number_child<int> ("SoundWriteBlock").get_value_or (48000);
+	if (_sound_write_block <= 0) {
+		/* Writing audio in blocks of no frames makes no sense */
+		_sound_write_block = 48000;
+	}
+	_scale_threads = max (1, f.optional_number_child<int> ("ScaleThreads").get_value_or (min (4U, max (1U, boost::thread::hardware_concurrency ()))));
 	_analyse_ebur128 = f.optional_bool_child("AnalyseEBUR128").get_value_or (true);
 	_automatic_audio_analysis = f.optional_bool_child ("AutomaticAudioAnalysis").get_value_or (false);
 #ifdef DCPOMATIC_WINDOWS
@@ -489,6 +501,8 @@ Config::write_config () const
 	root->add_child("MaximumJ2KBandwidth")->add_child_text (raw_convert<string> (_maximum_j2k_bandwidth));
 	root->add_child("AllowAnyDCPFrameRate")->add_child_text (_allow_any_dcp_frame_rate ? "1" : "0");
 	root->add_child("LogTypes")->add_child_text (raw_convert<string> (_log_types));
+	root->add_child("SoundWriteBlock")->add_child_text (raw_convert<string> (_sound_write_block));
+	root->add_child("ScaleThreads")->add_child_text (raw_convert<string> (_scale_threads));
 	root->add_child("AnalyseEBUR128")->add_child_text (_analyse_ebur128 ? "1" : "0");
 	root->add_child("AutomaticAudioAnalysis")->add_child_text (_automatic_audio_analysis ? "1" : "0");
 #ifdef DCPOMATIC_WINDOWS
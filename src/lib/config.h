@@ -264,6 +264,14 @@ public:
 		return _log_types;
 	}
 
+	int sound_write_block () const {
+		return _sound_write_block;
+	}
+
+	int scale_threads () const {
+		return _scale_threads;
+	}
+
 	bool analyse_ebur128 () const {
 		return _analyse_ebur128;
 	}
@@ -534,6 +542,14 @@ public:
 		maybe_set (_log_types, t);
 	}
 
+	void set_sound_write_block (int b) {
+		maybe_set (_sound_write_block, b);
+	}
+
+	void set_scale_threads (int t) {
+		maybe_set (_scale_threads, t);
+	}
+
 	void set_analyse_ebur128 (bool a) {
 		maybe_set (_analyse_ebur128, a);
 	}
@@ -740,6 +756,10 @@ private:
 	/** maximum allowed J2K bandwidth in bits per second */
 	int _maximum_j2k_bandwidth;
 	int _log_types;
+	/** number of audio frames to collect before writing them to a sound asset */
+	int _sound_write_block;
+	/** maximum number of threads to use to scale a single image; 1 to scale in the calling thread only */
+	int _scale_threads;
 	bool _analyse_ebur128;
 	bool _automatic_audio_analysis;
 #ifdef DCPOMATIC_WINDOWS
@@ -26,9 +26,16 @@ extern "C" {
 #include <libavformat/avio.h>
 }
 #include <boost/algorithm/string.hpp>
+#include <boost/scoped_array.hpp>
 #ifdef DCPOMATIC_LINUX
 #include <unistd.h>
 #include <mntent.h>
+#include <fcntl.h>
+#include <linux/falloc.h>
+#include <linux/fs.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
 #endif
 #ifdef DCPOMATIC_WINDOWS
 #include <windows.h>
@@ -61,6 +68,7 @@ using std::string;
 using std::wstring;
 using std::make_pair;
 using std::runtime_error;
+using std::min;
 using boost::shared_ptr;
 
 /** @param s Number of seconds to sleep for */
@@ -333,6 +341,175 @@ dcpomatic_fseek (FILE* stream, int64_t offset, int whence)
 #endif
 }
 
+/** Ask the filesystem to reserve space for a file which we are about to write
+ *  sequentially, so that it ends up in as few extents as possible.  The apparent
+ *  length of the file is not changed, so whoever is writing it does not need to know.
+ *  @param size Number of bytes to reserve.
+ *  @return 0 on success, or if reservation is not possible on this platform or
+ *  filesystem; otherwise an errno value (e.g. ENOSPC if there is not enough space).
+ */
+int
+preallocate_file (boost::filesystem::path p, int64_t size)
+{
+#ifdef DCPOMATIC_LINUX
+	int const fd = open (p.c_str(), O_WRONLY);
+	if (fd == -1) {
+		return 0;
+	}
+
+	int e = 0;
+	if (fallocate (fd, FALLOC_FL_KEEP_SIZE, 0, size) == -1) {
+		e = errno;
+		if (e == EOPNOTSUPP || e == ENOSYS) {
+			/* The filesystem can't do it; never mind */
+			e = 0;
+		} else {
+			/* Give back whatever we might have got before the failure */
+			struct stat st;
+			if (fstat (fd, &st) == 0) {
+				ftruncate (fd, st.st_size);
+			}
+		}
+	}
+
+	close (fd);
+	return e;
+#else
+	return 0;
+#endif
+}
+
+/** Release any space that was reserved by preallocate_file() but
+ *  which lies beyond the current end of the file.
+ */
+void
+release_preallocation (boost::filesystem::path p)
+{
+#ifdef DCPOMATIC_LINUX
+	int const fd = open (p.c_str(), O_WRONLY);
+	if (fd == -1) {
+		return;
+	}
+
+	/* Truncating to the current length frees blocks past the end of the file */
+	struct stat st;
+	if (fstat (fd, &st) == 0) {
+		ftruncate (fd, st.st_size);
+	}
+
+	close (fd);
+#endif
+}
+
+/** Copy a file ourselves, in large blocks */
+static void
+copy_file_streaming (boost::filesystem::path from, boost::filesystem::path to, boost::uintmax_t size, boost::function<void (float)> set_progress)
+{
+	FILE* in = fopen_boost (from, "rb");
+	if (!in) {
+		throw OpenFileError (from, errno, true);
+	}
+
+	FILE* out = fopen_boost (to, "wb");
+	if (!out) {
+		fclose (in);
+		throw OpenFileError (to, errno, false);
+	}
+
+	int const block = 4 * 1024 * 1024;
+	boost::scoped_array<uint8_t> buffer (new uint8_t[block]);
+	boost::uintmax_t done = 0;
+
+	try {
+		while (done < size) {
+			size_t const n = fread (buffer.get(), 1, min (boost::uintmax_t (block), size - done), in);
+			if (n == 0) {
+				if (feof (in)) {
+					/* The file has got shorter since we found its size */
+					throw FileError (String::compose (_("could not read from file %1 (it ended unexpectedly)"), from.string()), from);
+				}
+				throw ReadFileError (from, errno);
+			}
+			if (fwrite (buffer.get(), 1, n, out) != n) {
+				throw WriteFileError (to, errno);
+			}
+			done += n;
+			/* This may throw if we are being interrupted */
+			set_progress (float (done) / size);
+		}
+	} catch (...) {
+		fclose (in);
+		fclose (out);
+		throw;
+	}
+
+	fclose (in);
+	fclose (out);
+}
+
+/** Copy a file using the quickest way that the platform and filesystems allow.
+ *  On Linux we first try a reflink, so that a copy-on-write filesystem can share
+ *  the data, then copy_file_range(), which lets the kernel or a file server do the
+ *  copy without the data passing through us.  If neither of those is possible
+ *  we copy the data ourselves.
+ */
+void
+copy_file_fast (boost::filesystem::path from, boost::filesystem::path to, boost::function<void (float)> set_progress)
+{
+	boost::uintmax_t const size = boost::filesystem::file_size (from);
+
+#ifdef DCPOMATIC_LINUX
+	int const in = open (from.c_str(), O_RDONLY);
+	if (in == -1) {
+		throw OpenFileError (from, errno, true);
+	}
+
+	int const out = open (to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (out == -1) {
+		int const e = errno;
+		close (in);
+		throw OpenFileError (to, e, false);
+	}
+
+	bool done = false;
+
+#ifdef FICLONE
+	done = ioctl (out, FICLONE, in) == 0;
+#endif
+
+#ifdef SYS_copy_file_range
+	if (!done) {
+		boost::uintmax_t copied = 0;
+		while (copied < size) {
+			ssize_t const n = syscall (SYS_copy_file_range, in, 0, out, 0, min (boost::uintmax_t (64 * 1024 * 1024), size - copied), 0);
+			if (n <= 0) {
+				break;
+			}
+			copied += n;
+			try {
+				set_progress (float (copied) / size);
+			} catch (...) {
+				close (in);
+				close (out);
+				throw;
+			}
+		}
+		done = copied == size;
+	}
+#endif
+
+	close (in);
+	close (out);
+
+	if (done) {
+		set_progress (1);
+		return;
+	}
+#endif
+
+	copy_file_streaming (from, to, size, set_progress);
+}
+
 void
 Waker::nudge ()
 {
@@ -29,6 +29,7 @@
 #include <IOKit/pwr_mgt/IOPMLib.h>
 #endif
 #include <boost/filesystem.hpp>
+#include <boost/function.hpp>
 
 #ifdef DCPOMATIC_WINDOWS
 #define WEXITSTATUS(w) (w)
@@ -51,6 +52,9 @@ extern int dcpomatic_fseek (FILE *, int64_t, int);
 extern void start_batch_converter (boost::filesystem::path dcpomatic);
 extern uint64_t thread_id ();
 extern int avio_open_boost (AVIOContext** s, boost::filesystem::path file, int flags);
+extern int preallocate_file (boost::filesystem::path, int64_t size);
+extern void release_preallocation (boost::filesystem::path);
+extern void copy_file_fast (boost::filesystem::path from, boost::filesystem::path to, boost::function<void (float)> set_progress);
 
 /** @class Waker
  *  @brief A class which tries to keep the computer awake on various operating systems.
@@ -42,15 +42,31 @@
 #include <dcp/sound_frame.h>
 #include <dcp/sound_asset_reader.h>
 #include <boost/foreach.hpp>
+#include <algorithm>
 #include <iostream>
 
 using std::list;
 using std::cout;
+using std::vector;
+using std::lower_bound;
 using boost::shared_ptr;
 using boost::dynamic_pointer_cast;
 
+static bool
+starts_earlier (dcp::SubtitleString const & a, dcp::SubtitleString const & b)
+{
+	return a.in() < b.in();
+}
+
+static bool
+starts_before (dcp::SubtitleString const & a, dcp::Time const & t)
+{
+	return a.in() < t;
+}
+
 DCPDecoder::DCPDecoder (shared_ptr<const DCPContent> c, shared_ptr<Log> log)
 	: DCP (c)
+	, _next_subtitle (0)
 	, _decode_referenced (false)
 {
 	video.reset (new VideoDecoder (this, c, log));
@@ -140,11 +156,21 @@ DCPDecoder::pass ()
 
 	if ((*_reel)->main_subtitle() && (_decode_referenced || !_dcp_content->reference_subtitle())) {
 		int64_t const entry_point = (*_reel)->main_subtitle()->entry_point ();
-		list<dcp::SubtitleString> subs = (*_reel)->main_subtitle()->asset()->subtitles_during (
-			dcp::Time (entry_point + frame, vfr, vfr),
-			dcp::Time (entry_point + frame + 1, vfr, vfr),
-			true
-			);
+		dcp::Time const from (entry_point + frame, vfr, vfr);
+		dcp::Time const to (entry_point + frame + 1, vfr, vfr);
+
+		get_subtitles ();
+
+		/* Skip anything that started before this frame (e.g. before the reel's entry point) */
+		while (_next_subtitle < _subtitles.size() && _subtitles[_next_subtitle].in() < from) {
+			++_next_subtitle;
+		}
+
+		list<dcp::SubtitleString> subs;
+		while (_next_subtitle < _subtitles.size() && _subtitles[_next_subtitle].in() < to) {
+			subs.push_back (_subtitles[_next_subtitle]);
+			++_next_subtitle;
+		}
 
 		if (!subs.empty ()) {
 			/* XXX: assuming that all `subs' are at the same time; maybe this is ok */
@@ -212,6 +238,23 @@ DCPDecoder::get_readers ()
 	}
 }
 
+/** Make _subtitles the subtitles of the current reel, sorted by start time, if they are not
+ *  already; they are then ready to be emitted from the start of the reel.
+ */
+void
+DCPDecoder::get_subtitles ()
+{
+	if (_subtitle_reel == *_reel) {
+		return;
+	}
+
+	list<dcp::SubtitleString> const & subs = (*_reel)->main_subtitle()->asset()->subtitles ();
+	_subtitles = vector<dcp::SubtitleString> (subs.begin(), subs.end());
+	stable_sort (_subtitles.begin(), _subtitles.end(), starts_earlier);
+	_subtitle_reel = *_reel;
+	_next_subtitle = 0;
+}
+
 void
 DCPDecoder::seek (ContentTime t, bool accurate)
 {
@@ -227,6 +270,13 @@ DCPDecoder::seek (ContentTime t, bool accurate)
 	}
 
 	_next = t;
+
+	if (_reel != _reels.end() && (*_reel)->main_subtitle() && (_decode_referenced || !_dcp_content->reference_subtitle())) {
+		get_subtitles ();
+		double const vfr = _dcp_content->active_video_frame_rate ();
+		dcp::Time const from ((*_reel)->main_subtitle()->entry_point() + _next.frames_round (vfr), vfr, vfr);
+		_next_subtitle = lower_bound (_subtitles.begin(), _subtitles.end(), from, starts_before) - _subtitles.begin();
+	}
 }
 
 void
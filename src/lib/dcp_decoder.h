@@ -27,6 +27,7 @@
 #include <dcp/mono_picture_asset_reader.h>
 #include <dcp/stereo_picture_asset_reader.h>
 #include <dcp/sound_asset_reader.h>
+#include <dcp/subtitle_string.h>
 
 namespace dcp {
 	class Reel;
@@ -55,6 +56,7 @@ private:
 
 	void next_reel ();
 	void get_readers ();
+	void get_subtitles ();
 
 	/** Time of next thing to return from pass relative to the start of _reel */
 	ContentTime _next;
@@ -70,5 +72,12 @@ private:
 	/** Reader for current sound asset, if applicable */
 	boost::shared_ptr<dcp::SoundAssetReader> _sound_reader;
 
+	/** Reel that _subtitles were taken from */
+	boost::shared_ptr<dcp::Reel> _subtitle_reel;
+	/** Subtitles from _subtitle_reel's subtitle asset, in order of start time */
+	std::vector<dcp::SubtitleString> _subtitles;
+	/** Index into _subtitles of the next one to emit */
+	size_t _next_subtitle;
+
 	bool _decode_referenced;
 };
@@ -20,6 +20,7 @@
 
 #include "dcp_subtitle.h"
 #include "exceptions.h"
+#include "subtitle_file_cache.h"
 #include "compose.hpp"
 #include <dcp/interop_subtitle_asset.h>
 #include <dcp/smpte_subtitle_asset.h>
@@ -30,9 +31,17 @@ using std::string;
 using std::exception;
 using boost::shared_ptr;
 
-shared_ptr<dcp::SubtitleAsset>
+/** @return Parsed subtitles from `file'; these may be shared with other users
+ *  of the same file, so they must not be changed.
+ */
+shared_ptr<const dcp::SubtitleAsset>
 DCPSubtitle::load (boost::filesystem::path file) const
 {
+	shared_ptr<const dcp::SubtitleAsset> cached = SubtitleFileCache::instance()->get_dcp (file);
+	if (cached) {
+		return cached;
+	}
+
 	shared_ptr<dcp::SubtitleAsset> sc;
 	string interop_error;
 	string smpte_error;
@@ -55,5 +64,6 @@ DCPSubtitle::load (boost::filesystem::path file) const
 		throw FileError (String::compose (_("Could not read subtitles (%1 / %2)"), interop_error, smpte_error), file);
 	}
 
+	SubtitleFileCache::instance()->put_dcp (file, sc);
 	return sc;
 }
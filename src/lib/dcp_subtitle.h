@@ -31,7 +31,7 @@ namespace dcp {
 class DCPSubtitle
 {
 protected:
-	boost::shared_ptr<dcp::SubtitleAsset> load (boost::filesystem::path) const;
+	boost::shared_ptr<const dcp::SubtitleAsset> load (boost::filesystem::path) const;
 };
 
 #endif
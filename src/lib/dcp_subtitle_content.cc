@@ -55,10 +55,10 @@ DCPSubtitleContent::examine (shared_ptr<Job> job)
 {
 	Content::examine (job);
 
-	shared_ptr<dcp::SubtitleAsset> sc = load (path (0));
+	shared_ptr<const dcp::SubtitleAsset> sc = load (path (0));
 
-	shared_ptr<dcp::InteropSubtitleAsset> iop = dynamic_pointer_cast<dcp::InteropSubtitleAsset> (sc);
-	shared_ptr<dcp::SMPTESubtitleAsset> smpte = dynamic_pointer_cast<dcp::SMPTESubtitleAsset> (sc);
+	shared_ptr<const dcp::InteropSubtitleAsset> iop = dynamic_pointer_cast<const dcp::InteropSubtitleAsset> (sc);
+	shared_ptr<const dcp::SMPTESubtitleAsset> smpte = dynamic_pointer_cast<const dcp::SMPTESubtitleAsset> (sc);
 	if (smpte) {
 		set_video_frame_rate (smpte->edit_rate().numerator);
 	}
@@ -32,7 +32,7 @@ DCPSubtitleDecoder::DCPSubtitleDecoder (shared_ptr<const DCPSubtitleContent> con
 {
 	subtitle.reset (new SubtitleDecoder (this, content->subtitle, log));
 
-	shared_ptr<dcp::SubtitleAsset> c (load (content->path (0)));
+	shared_ptr<const dcp::SubtitleAsset> c (load (content->path (0)));
 	_subtitles = c->subtitles ();
 	_next = _subtitles.begin ();
 }
@@ -41,7 +41,6 @@
 #include <libcxml/cxml.h>
 #include <dcp/raw_convert.h>
 #include <dcp/openjpeg_image.h>
-#include <dcp/rgb_xyz.h>
 #include <dcp/j2k.h>
 #include <libxml++/libxml++.h>
 #include <boost/asio.hpp>
@@ -97,22 +96,12 @@ DCPVideo::DCPVideo (shared_ptr<const PlayerVideo> frame, shared_ptr<const cxml::
 shared_ptr<dcp::OpenJPEGImage>
 DCPVideo::convert_to_xyz (shared_ptr<const PlayerVideo> frame, dcp::NoteHandler note)
 {
-	shared_ptr<dcp::OpenJPEGImage> xyz;
-
-	shared_ptr<Image> image = frame->image (note, bind (&PlayerVideo::keep_xyz_or_rgb, _1), true, false);
 	if (frame->colour_conversion()) {
-		xyz = dcp::rgb_to_xyz (
-			image->data()[0],
-			image->size(),
-			image->stride()[0],
-			frame->colour_conversion().get(),
-			note
-			);
-	} else {
-		xyz.reset (new dcp::OpenJPEGImage (image->data()[0], image->size(), image->stride()[0]));
+		return frame->xyz_image (note);
 	}
 
-	return xyz;
+	shared_ptr<Image> image = frame->image (note, bind (&PlayerVideo::keep_xyz_or_rgb, _1), true, false);
+	return shared_ptr<dcp::OpenJPEGImage> (new dcp::OpenJPEGImage (image->data()[0], image->size(), image->stride()[0]));
 }
 
 /** J2K-encode this frame on the local host.
@@ -212,6 +212,14 @@ FFmpeg::setup_decoders ()
 			*/
 			av_dict_set_int (&options, "strict", FF_COMPLIANCE_EXPERIMENTAL, 0);
 
+			if (context->codec_type == AVMEDIA_TYPE_VIDEO) {
+				/* Ask for decoded video frames which we can keep references to, so that
+				   Image can use their data without copying it.  This means that we must
+				   av_frame_unref() each frame when we have finished with it.
+				*/
+				context->refcounted_frames = 1;
+			}
+
 			if (avcodec_open2 (context, codec, &options) < 0) {
 				throw DecodeError (N_("could not open decoder"));
 			}
@@ -501,6 +501,8 @@ FFmpegDecoder::decode_video_packet ()
 		}
 	}
 
+	av_frame_unref (_frame);
+
 	return true;
 }
 
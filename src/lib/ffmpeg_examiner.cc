@@ -160,6 +160,7 @@ FFmpegExaminer::video_packet (AVCodecContext* context)
 				_format_context->streams[_video_stream.get()]
 				).get_value_or (ContentTime ()).frames_round (video_frame_rate().get ());
 		}
+		av_frame_unref (_frame);
 	}
 }
 
@@ -244,6 +244,15 @@ Film::info_file (DCPTimePeriod period) const
 	return file (p);
 }
 
+/** @return Path of a file which records frames of the video asset for
+ *  a period which are known to have been written correctly.
+ */
+boost::filesystem::path
+Film::journal_file (DCPTimePeriod period) const
+{
+	return info_file(period).string() + ".journal";
+}
+
 boost::filesystem::path
 Film::internal_video_asset_dir () const
 {
@@ -31,3 +31,18 @@ operator!= (FontFiles const & a, FontFiles const & b)
 
 	return false;
 }
+
+/** An arbitrary ordering so that FontFiles can be used as a map key */
+bool
+operator< (FontFiles const & a, FontFiles const & b)
+{
+	for (int i = 0; i < FontFiles::VARIANTS; ++i) {
+		boost::optional<boost::filesystem::path> const p = a.get (static_cast<FontFiles::Variant> (i));
+		boost::optional<boost::filesystem::path> const q = b.get (static_cast<FontFiles::Variant> (i));
+		if (p != q) {
+			return p < q;
+		}
+	}
+
+	return false;
+}
@@ -47,5 +47,6 @@ private:
 };
 
 bool operator!= (FontFiles const & a, FontFiles const & b);
+bool operator< (FontFiles const & a, FontFiles const & b);
 
 #endif
@@ -0,0 +1,157 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/** @file  src/lib/fused_xyz.cc
+ *  @brief Preparation of XYZ frames for JPEG2000 encoding in a single pass.
+ *
+ *  Doing the subtitle blend, fade and colour conversion one after the other
+ *  on a whole frame means reading and writing the frame from main memory
+ *  several times.  Here we do all three on a band of a few rows at a time, so
+ *  that the band is still in cache for the second and third steps.
+ */
+
+#include "fused_xyz.h"
+#include "image.h"
+#include "image_kernels.h"
+#include "simd.h"
+#include "xyz_converter.h"
+#include "colour_conversion.h"
+#include "dcpomatic_assert.h"
+#include "compose.hpp"
+#include <dcp/openjpeg_image.h>
+#include <boost/foreach.hpp>
+#include <algorithm>
+#include <vector>
+
+using std::min;
+using std::max;
+using std::list;
+using std::vector;
+using boost::shared_ptr;
+using boost::optional;
+
+/** Approximate number of bytes of source image to process in each band */
+static int const band_bytes = 128 * 1024;
+
+/** The part of each row of an image that a subtitle covers */
+struct SubtitleSpan
+{
+	SubtitleSpan (PositionImage const & subtitle_, dcp::Size size)
+		: subtitle (subtitle_)
+	{
+		/* As Image::alpha_blend does it */
+		tx = max (0, subtitle.position.x);
+		ox = tx - subtitle.position.x;
+		width = min (size.width - tx, subtitle.image->size().width - ox);
+	}
+
+	PositionImage subtitle;
+	/** x position in the image of the first pixel covered */
+	int tx;
+	/** x position in the subtitle of the first pixel that covers the image */
+	int ox;
+	/** number of pixels covered */
+	int width;
+};
+
+/** Blend subtitles, fade and convert to XYZ; the result is the same as calling
+ *  Image::alpha_blend (for each subtitle), Image::fade and then dcp::rgb_to_xyz,
+ *  but much less memory bandwidth is needed.
+ *
+ *  @param rgb Scaled RGB48LE image; this will be modified.
+ *  @param subtitles Subtitles to blend onto the image, in order.
+ *  @param fade Fade to apply, if any (0 is black, 1 is no fade).
+ *  @param conversion Colour conversion to use.
+ *  @param note Handler for notes about the conversion.
+ *  @return XYZ image.
+ */
+shared_ptr<dcp::OpenJPEGImage>
+fused_rgb_to_xyz (
+	shared_ptr<Image> rgb,
+	list<PositionImage> const & subtitles,
+	optional<double> fade,
+	ColourConversion const & conversion,
+	dcp::NoteHandler note
+	)
+{
+	DCPOMATIC_ASSERT (rgb->pixel_format() == AV_PIX_FMT_RGB48LE);
+	rgb->make_writable ();
+
+	dcp::Size const size = rgb->size ();
+	shared_ptr<dcp::OpenJPEGImage> xyz (new dcp::OpenJPEGImage (size));
+
+	shared_ptr<const XYZConverter> converter = XYZConverter::get (conversion);
+
+	vector<SubtitleSpan> spans;
+	BOOST_FOREACH (PositionImage const & i, subtitles) {
+		DCPOMATIC_ASSERT (i.image->pixel_format() == AV_PIX_FMT_RGBA);
+		SubtitleSpan const span (i, size);
+		if (span.width > 0) {
+			spans.push_back (span);
+		}
+	}
+
+	SIMDLevel const level = simd_level ();
+	int const band = max (1, band_bytes / rgb->line_size()[0]);
+	int clamped = 0;
+
+	for (int y = 0; y < size.height; y += band) {
+		int const rows = min (band, size.height - y);
+
+		BOOST_FOREACH (SubtitleSpan const & j, spans) {
+			for (int i = y; i < y + rows; ++i) {
+				int const oy = i - j.subtitle.position.y;
+				if (oy >= 0 && oy < j.subtitle.image->size().height) {
+					alpha_blend_row (
+						AV_PIX_FMT_RGB48LE,
+						rgb->data()[0] + i * rgb->stride()[0] + j.tx * 6,
+						j.subtitle.image->data()[0] + oy * j.subtitle.image->stride()[0] + j.ox * 4,
+						j.width,
+						level
+						);
+				}
+			}
+		}
+
+		if (fade) {
+			for (int i = y; i < y + rows; ++i) {
+				fade_row_16le (reinterpret_cast<uint16_t*> (rgb->data()[0] + i * rgb->stride()[0]), rgb->line_size()[0] / 2, fade.get(), level);
+			}
+		}
+
+		for (int i = y; i < y + rows; ++i) {
+			int const offset = i * size.width;
+			clamped += converter->convert_row (
+				reinterpret_cast<uint16_t const *> (rgb->data()[0] + i * rgb->stride()[0]),
+				size.width,
+				xyz->data(0) + offset,
+				xyz->data(1) + offset,
+				xyz->data(2) + offset,
+				level
+				);
+		}
+	}
+
+	if (clamped && note) {
+		note (dcp::DCP_NOTE, String::compose ("%1 XYZ value(s) clamped", clamped));
+	}
+
+	return xyz;
+}
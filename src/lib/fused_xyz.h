@@ -0,0 +1,49 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/** @file  src/lib/fused_xyz.h
+ *  @brief Preparation of XYZ frames for JPEG2000 encoding in a single pass.
+ */
+
+#ifndef DCPOMATIC_FUSED_XYZ_H
+#define DCPOMATIC_FUSED_XYZ_H
+
+#include "position_image.h"
+#include <dcp/types.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/optional.hpp>
+#include <list>
+
+class Image;
+class ColourConversion;
+
+namespace dcp {
+	class OpenJPEGImage;
+}
+
+extern boost::shared_ptr<dcp::OpenJPEGImage> fused_rgb_to_xyz (
+	boost::shared_ptr<Image> rgb,
+	std::list<PositionImage> const & subtitles,
+	boost::optional<double> fade,
+	ColourConversion const & conversion,
+	dcp::NoteHandler note
+	);
+
+#endif
@@ -25,17 +25,21 @@
 #include "image.h"
 #include "exceptions.h"
 #include "timer.h"
-#include "rect.h"
 #include "util.h"
 #include "dcpomatic_socket.h"
-#include <dcp/rgb_xyz.h>
-#include <dcp/transfer_function.h>
+#include "sws_context_cache.h"
+#include "image_buffer_pool.h"
+#include "image_kernels.h"
+#include "simd.h"
+#include "config.h"
+#include "worker_pool.h"
 extern "C" {
 #include <libswscale/swscale.h>
 #include <libavutil/pixfmt.h>
 #include <libavutil/pixdesc.h>
 #include <libavutil/frame.h>
 }
+#include <boost/bind.hpp>
 #include <iostream>
 
 #include "i18n.h"
@@ -46,7 +50,7 @@ using std::max;
 using std::cout;
 using std::cerr;
 using std::list;
-using std::runtime_error;
+using std::bad_alloc;
 using boost::shared_ptr;
 using dcp::Size;
 
@@ -107,6 +111,187 @@ Image::planes () const
 	return d->nb_components;
 }
 
+/** Minimum number of output rows that it is worth giving to a thread when scaling */
+static int const minimum_scale_band = 64;
+
+/** Description of a scale which is split into horizontal bands so that
+ *  the bands can be scaled in parallel.
+ *
+ *  Each band is scaled separately, along with some rows of overlap on each
+ *  side so that the scaler's filters see the same input as they would if the
+ *  whole image were scaled in one go.  Band boundaries are placed where the
+ *  input and output rows line up exactly, on chroma rows of the input and on
+ *  the start of swscale's 8-row dither patterns in the output.
+ */
+struct BandedScale
+{
+	BandedScale (
+		uint8_t* const * in_data_, int const * in_stride_, dcp::Size in_size_, AVPixelFormat in_format_,
+		uint8_t* const * out_data_, int const * out_stride_, dcp::Size out_size_, AVPixelFormat out_format_,
+		dcp::YUVToRGB yuv_to_rgb_, int flags_
+		)
+		: in_data (in_data_)
+		, in_stride (in_stride_)
+		, in_size (in_size_)
+		, in_format (in_format_)
+		, out_data (out_data_)
+		, out_stride (out_stride_)
+		, out_size (out_size_)
+		, out_format (out_format_)
+		, yuv_to_rgb (yuv_to_rgb_)
+		, flags (flags_)
+		, unit_in (0)
+		, unit_out (0)
+		, units (0)
+		, margin (0)
+		, bands (1)
+	{}
+
+	bool plan (int threads);
+	void scale (int band) const;
+
+	int in_row (int unit) const {
+		return min (in_size.height, unit * unit_in);
+	}
+
+	int out_row (int unit) const {
+		return min (out_size.height, unit * unit_out);
+	}
+
+	uint8_t* const * in_data;
+	int const * in_stride;
+	dcp::Size in_size;
+	AVPixelFormat in_format;
+	uint8_t* const * out_data;
+	int const * out_stride;
+	dcp::Size out_size;
+	AVPixelFormat out_format;
+	dcp::YUVToRGB yuv_to_rgb;
+	int flags;
+
+	/** number of input rows in each unit; bands start and end on unit boundaries */
+	int unit_in;
+	/** number of output rows in each unit */
+	int unit_out;
+	/** number of units in the image; the last one may be partial */
+	int units;
+	/** number of units of overlap to scale on each side of a band */
+	int margin;
+	int bands;
+};
+
+/** Work out how to split the scale into bands.
+ *  @param threads Maximum number of bands to use.
+ *  @return true if it is worth splitting the scale.
+ */
+bool
+BandedScale::plan (int threads)
+{
+	AVPixFmtDescriptor const * in_desc = av_pix_fmt_desc_get (in_format);
+	if (!in_desc || (in_desc->flags & AV_PIX_FMT_FLAG_PAL) || in_size.height == 0 || out_size.height == 0) {
+		return false;
+	}
+
+	int a = in_size.height;
+	int b = out_size.height;
+	while (b) {
+		int const t = a % b;
+		a = b;
+		b = t;
+	}
+
+	unit_in = in_size.height / a;
+	unit_out = out_size.height / a;
+	int const in_factor = 1 << in_desc->log2_chroma_h;
+	while ((unit_in % in_factor) || (unit_out % 8)) {
+		unit_in *= 2;
+		unit_out *= 2;
+	}
+
+	units = (out_size.height + unit_out - 1) / unit_out;
+
+	/* This is more than the reach of any of swscale's vertical filters */
+	int const margin_rows = 8 * in_factor * max (1, (in_size.height + out_size.height - 1) / out_size.height);
+	margin = (margin_rows + unit_in - 1) / unit_in;
+
+	bands = min (threads, min (units, out_size.height / minimum_scale_band));
+	return bands > 1;
+}
+
+/** Scale one band; this may be called from any thread */
+void
+BandedScale::scale (int band) const
+{
+	int const u0 = band * units / bands;
+	int const u1 = (band + 1) * units / bands;
+	int const m0 = max (0, u0 - margin);
+	int const m1 = min (units, u1 + margin);
+
+	AVPixFmtDescriptor const * in_desc = av_pix_fmt_desc_get (in_format);
+	DCPOMATIC_ASSERT (in_desc);
+
+	uint8_t const * band_in[4] = { 0, 0, 0, 0 };
+	for (int c = 0; c < av_pix_fmt_count_planes (in_format); ++c) {
+		int const vf = (c == 1 || c == 2) ? (1 << in_desc->log2_chroma_h) : 1;
+		band_in[c] = in_data[c] + (in_row (m0) / vf) * in_stride[c];
+	}
+
+	dcp::Size const band_in_size (in_size.width, in_row (m1) - in_row (m0));
+	Image band_out (out_format, dcp::Size (out_size.width, out_row (m1) - out_row (m0)), true);
+
+	{
+		SwsContextCache::Holder scale_context (SwsContextCache::Key (band_in_size, in_format, band_out.size(), out_format, yuv_to_rgb, flags));
+		sws_scale (
+			scale_context.get(),
+			band_in, in_stride,
+			0, band_in_size.height,
+			band_out.data(), band_out.stride()
+			);
+	}
+
+	/* Copy the part of the band that we want, leaving out the overlap */
+	for (int c = 0; c < band_out.planes(); ++c) {
+		int const vf = band_out.vertical_factor (c);
+		int const first = (out_row (u0) - out_row (m0)) / vf;
+		int const last = u1 == units ? band_out.sample_size(c).height : (out_row (u1) - out_row (m0)) / vf;
+		uint8_t const * p = band_out.data()[c] + first * band_out.stride()[c];
+		uint8_t* q = out_data[c] + (out_row (u0) / vf) * out_stride[c];
+		for (int y = first; y < last; ++y) {
+			memcpy (q, p, band_out.line_size()[c]);
+			p += band_out.stride()[c];
+			q += out_stride[c];
+		}
+	}
+}
+
+/** Scale some image data using swscale, splitting the job between threads if
+ *  Config::scale_threads says that we should.
+ */
+static void
+scale_data (
+	uint8_t* const * in_data, int const * in_stride, dcp::Size in_size, AVPixelFormat in_format,
+	uint8_t* const * out_data, int const * out_stride, dcp::Size out_size, AVPixelFormat out_format,
+	dcp::YUVToRGB yuv_to_rgb, int flags
+	)
+{
+	int const threads = Config::instance()->scale_threads ();
+	if (threads > 1) {
+		BandedScale banded (in_data, in_stride, in_size, in_format, out_data, out_stride, out_size, out_format, yuv_to_rgb, flags);
+		if (banded.plan (threads)) {
+			WorkerPool::instance()->run (banded.bands, boost::bind (&BandedScale::scale, &banded, _1));
+			return;
+		}
+	}
+
+	SwsContextCache::Holder scale_context (SwsContextCache::Key (in_size, in_format, out_size, out_format, yuv_to_rgb, flags));
+	sws_scale (
+		scale_context.get(),
+		in_data, in_stride,
+		0, in_size.height,
+		out_data, out_stride
+		);
+}
+
 /** Crop this image, scale it to `inter_size' and then place it in a black frame of `out_size'.
  *  @param crop Amount to crop by.
  *  @param inter_size Size to scale the cropped image to.
@@ -115,7 +300,7 @@ Image::planes () const
  *  @param out_format Output pixel format.
  *  @param out_aligned true to make the output image aligned.
  *  @param fast Try to be fast at the possible expense of quality; at present this means using
- *  fast bilinear rather than bicubic scaling.
+ *  fast bilinear rather than bicubic scaling, and an approximate conversion from XYZ to RGB24.
  */
 shared_ptr<Image>
 Image::crop_scale_window (
@@ -127,6 +312,13 @@ Image::crop_scale_window (
 	*/
 	DCPOMATIC_ASSERT (aligned ());
 
+	if (fast && _pixel_format == AV_PIX_FMT_XYZ12LE && out_format == AV_PIX_FMT_RGB24) {
+		/* This is (probably) a preview of a DCP.  Converting the colour ourselves
+		   is much faster than letting swscale do it, and swscale then only has to scale.
+		*/
+		return xyz_to_rgb24_preview(crop)->crop_scale_window (Crop (), inter_size, out_size, yuv_to_rgb, out_format, out_aligned, fast);
+	}
+
 	DCPOMATIC_ASSERT (out_size.width >= inter_size.width);
 	DCPOMATIC_ASSERT (out_size.height >= inter_size.height);
 
@@ -158,35 +350,37 @@ Image::crop_scale_window (
 	/* Size of the image after any crop */
 	dcp::Size const cropped_size = crop.apply (size ());
 
-	/* Scale context for a scale from cropped_size to inter_size */
-	struct SwsContext* scale_context = sws_getContext (
-			cropped_size.width, cropped_size.height, pixel_format(),
-			inter_size.width, inter_size.height, out_format,
-			fast ? SWS_FAST_BILINEAR : SWS_BICUBIC, 0, 0, 0
-		);
-
-	if (!scale_context) {
-		throw runtime_error (N_("Could not allocate SwsContext"));
-	}
-
-	DCPOMATIC_ASSERT (yuv_to_rgb < dcp::YUV_TO_RGB_COUNT);
-	int const lut[dcp::YUV_TO_RGB_COUNT] = {
-		SWS_CS_ITU601,
-		SWS_CS_ITU709
-	};
-
-	sws_setColorspaceDetails (
-		scale_context,
-		sws_getCoefficients (lut[yuv_to_rgb]), 0,
-		sws_getCoefficients (lut[yuv_to_rgb]), 0,
-		0, 1 << 16, 1 << 16
-		);
+	/* Corner of the image within out_size */
+	Position<int> const corner ((out_size.width - inter_size.width) / 2, (out_size.height - inter_size.height) / 2);
 
 	AVPixFmtDescriptor const * desc = av_pix_fmt_desc_get (_pixel_format);
 	if (!desc) {
 		throw PixelFormatError ("crop_scale_window()", _pixel_format);
 	}
 
+	if (
+		out_format == AV_PIX_FMT_RGB48LE &&
+		yuv_to_rgb48le_supported (_pixel_format) &&
+		(fast || (desc->log2_chroma_w == 0 && desc->log2_chroma_h == 0)) &&
+		cropped_size == inter_size &&
+		(crop.left + cropped_size.width) <= size().width &&
+		(crop.top + cropped_size.height) <= size().height
+		) {
+		/* There is no scaling to do, and we can crop and convert this format to RGB
+		   more quickly than swscale can.  We upsample subsampled chroma linearly,
+		   which is not what swscale's bicubic filter does, so we only do that when
+		   a fast result is wanted; without subsampling our result is the same as
+		   swscale's (give or take rounding).
+		*/
+		yuv_to_rgb48le (
+			_pixel_format, yuv_to_rgb, data(), stride(), size(),
+			crop.left, crop.top, cropped_size,
+			out->data()[0] + corner.x * 6 + out->stride()[0] * corner.y, out->stride()[0],
+			simd_level ()
+			);
+		return out;
+	}
+
 	/* Prepare input data pointers with crop */
 	uint8_t* scale_in_data[planes()];
 	for (int c = 0; c < planes(); ++c) {
@@ -199,26 +393,47 @@ Image::crop_scale_window (
 		scale_in_data[c] = data()[c] + x + stride()[c] * (crop.top / vertical_factor(c));
 	}
 
-	/* Corner of the image within out_size */
-	Position<int> const corner ((out_size.width - inter_size.width) / 2, (out_size.height - inter_size.height) / 2);
-
 	uint8_t* scale_out_data[out->planes()];
 	for (int c = 0; c < out->planes(); ++c) {
 		scale_out_data[c] = out->data()[c] + lrintf (out->bytes_per_pixel(c) * corner.x) + out->stride()[c] * corner.y;
 	}
 
-	sws_scale (
-		scale_context,
-		scale_in_data, stride(),
-		0, cropped_size.height,
-		scale_out_data, out->stride()
+	/* Scale from cropped_size to inter_size */
+	scale_data (
+		scale_in_data, stride(), cropped_size, pixel_format(),
+		scale_out_data, out->stride(), inter_size, out_format,
+		yuv_to_rgb, fast ? SWS_FAST_BILINEAR : SWS_BICUBIC
 		);
 
-	sws_freeContext (scale_context);
-
 	return out;
 }
 
+/** Crop an XYZ12LE image and convert it quickly to RGB24.  The colour conversion
+ *  is close to what swscale would do, but not exactly the same.
+ *  @param crop Amount to crop by.
+ *  @return Aligned RGB24 image.
+ */
+shared_ptr<Image>
+Image::xyz_to_rgb24_preview (Crop crop) const
+{
+	DCPOMATIC_ASSERT (_pixel_format == AV_PIX_FMT_XYZ12LE);
+
+	dcp::Size const cropped_size = crop.apply (size ());
+	shared_ptr<Image> rgb (new Image (AV_PIX_FMT_RGB24, cropped_size, true));
+
+	SIMDLevel const level = simd_level ();
+	for (int y = 0; y < cropped_size.height; ++y) {
+		xyz12le_to_rgb24_row (
+			reinterpret_cast<uint16_t const *> (data()[0] + (y + crop.top) * stride()[0]) + crop.left * 3,
+			rgb->data()[0] + y * rgb->stride()[0],
+			cropped_size.width,
+			level
+			);
+	}
+
+	return rgb;
+}
+
 /** @param out_size Size to scale to.
  *  @param yuv_to_rgb YUVToRGB transform transform to use, if required.
  *  @param out_format Output pixel format.
@@ -236,34 +451,12 @@ Image::scale (dcp::Size out_size, dcp::YUVToRGB yuv_to_rgb, AVPixelFormat out_fo
 
 	shared_ptr<Image> scaled (new Image (out_format, out_size, out_aligned));
 
-	struct SwsContext* scale_context = sws_getContext (
-		size().width, size().height, pixel_format(),
-		out_size.width, out_size.height, out_format,
-		fast ? SWS_FAST_BILINEAR : SWS_BICUBIC, 0, 0, 0
+	scale_data (
+		data(), stride(), size(), pixel_format(),
+		scaled->data(), scaled->stride(), out_size, out_format,
+		yuv_to_rgb, fast ? SWS_FAST_BILINEAR : SWS_BICUBIC
 		);
 
-	DCPOMATIC_ASSERT (yuv_to_rgb < dcp::YUV_TO_RGB_COUNT);
-	int const lut[dcp::YUV_TO_RGB_COUNT] = {
-		SWS_CS_ITU601,
-		SWS_CS_ITU709
-	};
-
-	sws_setColorspaceDetails (
-		scale_context,
-		sws_getCoefficients (lut[yuv_to_rgb]), 0,
-		sws_getCoefficients (lut[yuv_to_rgb]), 0,
-		0, 1 << 16, 1 << 16
-		);
-
-	sws_scale (
-		scale_context,
-		data(), stride(),
-		0, size().height,
-		scaled->data(), scaled->stride()
-		);
-
-	sws_freeContext (scale_context);
-
 	return scaled;
 }
 
@@ -298,6 +491,8 @@ Image::swap_16 (uint16_t v)
 void
 Image::make_black ()
 {
+	make_writable ();
+
 	/* U/V black value for 8-bit colour */
 	static uint8_t const eight_bit_uv =	(1 << 7) - 1;
 	/* U/V black value for 9-bit colour */
@@ -422,6 +617,8 @@ Image::make_black ()
 void
 Image::make_transparent ()
 {
+	make_writable ();
+
 	if (_pixel_format != AV_PIX_FMT_RGBA) {
 		throw PixelFormatError ("make_transparent()", _pixel_format);
 	}
@@ -462,6 +659,8 @@ component (
 void
 Image::alpha_blend (shared_ptr<const Image> other, Position<int> position)
 {
+	make_writable ();
+
 	/* We're blending RGBA images; first byte is blue, second byte is green, third byte blue, fourth byte alpha */
 	DCPOMATIC_ASSERT (other->pixel_format() == AV_PIX_FMT_RGBA);
 	int const other_bpp = 4;
@@ -484,95 +683,22 @@ Image::alpha_blend (shared_ptr<const Image> other, Position<int> position)
 
 	switch (_pixel_format) {
 	case AV_PIX_FMT_RGB24:
-	{
-		/* Going onto RGB24.  First byte is red, second green, third blue */
-		int const this_bpp = 3;
-		for (int ty = start_ty, oy = start_oy; ty < size().height && oy < other->size().height; ++ty, ++oy) {
-			uint8_t* tp = data()[0] + ty * stride()[0] + start_tx * this_bpp;
-			uint8_t* op = other->data()[0] + oy * other->stride()[0];
-			for (int tx = start_tx, ox = start_ox; tx < size().width && ox < other->size().width; ++tx, ++ox) {
-				float const alpha = float (op[3]) / 255;
-				tp[0] = op[2] * alpha + tp[0] * (1 - alpha);
-				tp[1] = op[1] * alpha + tp[1] * (1 - alpha);
-				tp[2] = op[0] * alpha + tp[2] * (1 - alpha);
-
-				tp += this_bpp;
-				op += other_bpp;
-			}
-		}
-		break;
-	}
 	case AV_PIX_FMT_BGRA:
 	case AV_PIX_FMT_RGBA:
-	{
-		int const this_bpp = 4;
-		for (int ty = start_ty, oy = start_oy; ty < size().height && oy < other->size().height; ++ty, ++oy) {
-			uint8_t* tp = data()[0] + ty * stride()[0] + start_tx * this_bpp;
-			uint8_t* op = other->data()[0] + oy * other->stride()[0];
-			for (int tx = start_tx, ox = start_ox; tx < size().width && ox < other->size().width; ++tx, ++ox) {
-				float const alpha = float (op[3]) / 255;
-				tp[0] = op[0] * alpha + tp[0] * (1 - alpha);
-				tp[1] = op[1] * alpha + tp[1] * (1 - alpha);
-				tp[2] = op[2] * alpha + tp[2] * (1 - alpha);
-				tp[3] = op[3] * alpha + tp[3] * (1 - alpha);
-
-				tp += this_bpp;
-				op += other_bpp;
-			}
-		}
-		break;
-	}
 	case AV_PIX_FMT_RGB48LE:
-	{
-		int const this_bpp = 6;
-		for (int ty = start_ty, oy = start_oy; ty < size().height && oy < other->size().height; ++ty, ++oy) {
-			uint8_t* tp = data()[0] + ty * stride()[0] + start_tx * this_bpp;
-			uint8_t* op = other->data()[0] + oy * other->stride()[0];
-			for (int tx = start_tx, ox = start_ox; tx < size().width && ox < other->size().width; ++tx, ++ox) {
-				float const alpha = float (op[3]) / 255;
-				/* Blend high bytes; the RGBA in op appears to be BGRA */
-				tp[1] = op[2] * alpha + tp[1] * (1 - alpha);
-				tp[3] = op[1] * alpha + tp[3] * (1 - alpha);
-				tp[5] = op[0] * alpha + tp[5] * (1 - alpha);
-
-				tp += this_bpp;
-				op += other_bpp;
-			}
-		}
-		break;
-	}
 	case AV_PIX_FMT_XYZ12LE:
 	{
-		dcp::ColourConversion conv = dcp::ColourConversion::srgb_to_xyz();
-		double fast_matrix[9];
-		dcp::combined_rgb_to_xyz (conv, fast_matrix);
-		double const * lut_in = conv.in()->lut (8, false);
-		double const * lut_out = conv.out()->lut (16, true);
-		int const this_bpp = 6;
+		/* These are done a row at a time by the kernels in image_kernels.cc */
+		int const this_bpp = lrintf (bytes_per_pixel (0));
+		int const width = min (size().width - start_tx, other->size().width - start_ox);
+		if (width <= 0) {
+			break;
+		}
+		SIMDLevel const level = simd_level ();
 		for (int ty = start_ty, oy = start_oy; ty < size().height && oy < other->size().height; ++ty, ++oy) {
-			uint16_t* tp = reinterpret_cast<uint16_t*> (data()[0] + ty * stride()[0] + start_tx * this_bpp);
-			uint8_t* op = other->data()[0] + oy * other->stride()[0];
-			for (int tx = start_tx, ox = start_ox; tx < size().width && ox < other->size().width; ++tx, ++ox) {
-				float const alpha = float (op[3]) / 255;
-
-				/* Convert sRGB to XYZ; op is BGRA.  First, input gamma LUT */
-				double const r = lut_in[op[2]];
-				double const g = lut_in[op[1]];
-				double const b = lut_in[op[0]];
-
-				/* RGB to XYZ, including Bradford transform and DCI companding */
-				double const x = max (0.0, min (65535.0, r * fast_matrix[0] + g * fast_matrix[1] + b * fast_matrix[2]));
-				double const y = max (0.0, min (65535.0, r * fast_matrix[3] + g * fast_matrix[4] + b * fast_matrix[5]));
-				double const z = max (0.0, min (65535.0, r * fast_matrix[6] + g * fast_matrix[7] + b * fast_matrix[8]));
-
-				/* Out gamma LUT and blend */
-				tp[0] = lrint(lut_out[lrint(x)] * 65535) * alpha + tp[0] * (1 - alpha);
-				tp[1] = lrint(lut_out[lrint(y)] * 65535) * alpha + tp[1] * (1 - alpha);
-				tp[2] = lrint(lut_out[lrint(z)] * 65535) * alpha + tp[2] * (1 - alpha);
-
-				tp += this_bpp / 2;
-				op += other_bpp;
-			}
+			uint8_t* tp = data()[0] + ty * stride()[0] + start_tx * this_bpp;
+			uint8_t const * op = other->data()[0] + oy * other->stride()[0] + start_ox * other_bpp;
+			alpha_blend_row (_pixel_format, tp, op, width, level);
 		}
 		break;
 	}
@@ -600,6 +726,8 @@ Image::alpha_blend (shared_ptr<const Image> other, Position<int> position)
 void
 Image::copy (shared_ptr<const Image> other, Position<int> position)
 {
+	make_writable ();
+
 	/* Only implemented for RGB24 onto RGB24 so far */
 	DCPOMATIC_ASSERT (_pixel_format == AV_PIX_FMT_RGB24 && other->pixel_format() == AV_PIX_FMT_RGB24);
 	DCPOMATIC_ASSERT (position.x >= 0 && position.y >= 0);
@@ -615,6 +743,8 @@ Image::copy (shared_ptr<const Image> other, Position<int> position)
 void
 Image::read_from_socket (shared_ptr<Socket> socket)
 {
+	make_writable ();
+
 	for (int i = 0; i < planes(); ++i) {
 		uint8_t* p = data()[i];
 		int const lines = sample_size(i).height;
@@ -697,12 +827,13 @@ Image::Image (AVPixelFormat p, dcp::Size s, bool aligned, int extra_pixels)
 	, _pixel_format (p)
 	, _aligned (aligned)
 	, _extra_pixels (extra_pixels)
+	, _frame (0)
 {
 	allocate ();
 }
 
 void
-Image::allocate ()
+Image::allocate_arrays ()
 {
 	_data = (uint8_t **) wrapped_av_malloc (4 * sizeof (uint8_t *));
 	_data[0] = _data[1] = _data[2] = _data[3] = 0;
@@ -712,6 +843,12 @@ Image::allocate ()
 
 	_stride = (int *) wrapped_av_malloc (4 * sizeof (int));
 	_stride[0] = _stride[1] = _stride[2] = _stride[3] = 0;
+}
+
+void
+Image::allocate ()
+{
+	allocate_arrays ();
 
 	for (int i = 0; i < planes(); ++i) {
 		_line_size[i] = ceil (_size.width * bytes_per_pixel(i));
@@ -731,15 +868,23 @@ Image::allocate ()
 		   so I'll just over-allocate by 32 bytes and have done with it.  Empirical
 		   testing suggests that it works.
 		*/
-		_data[i] = (uint8_t *) wrapped_av_malloc (_stride[i] * sample_size(i).height + _extra_pixels * bytes_per_pixel(i) + 32);
+		_data[i] = ImageBufferPool::instance()->get (plane_allocation (i));
 	}
 }
 
+/** @return Number of bytes that we allocate for a given plane */
+size_t
+Image::plane_allocation (int i) const
+{
+	return _stride[i] * sample_size(i).height + _extra_pixels * bytes_per_pixel(i) + 32;
+}
+
 Image::Image (Image const & other)
 	: _size (other._size)
 	, _pixel_format (other._pixel_format)
 	, _aligned (other._aligned)
 	, _extra_pixels (other._extra_pixels)
+	, _frame (0)
 {
 	allocate ();
 
@@ -755,12 +900,35 @@ Image::Image (Image const & other)
 	}
 }
 
+/** Make an Image from an AVFrame.  If possible the Image will use the frame's
+ *  data without copying it, by taking a reference to the frame's buffers; the
+ *  data will be copied later if the Image is modified while the buffers are
+ *  still in use elsewhere (see make_writable()).  The caller may unref or free
+ *  the frame as soon as this constructor returns.
+ */
 Image::Image (AVFrame* frame)
 	: _size (frame->width, frame->height)
 	, _pixel_format (static_cast<AVPixelFormat> (frame->format))
 	, _aligned (true)
 	, _extra_pixels (0)
+	, _frame (0)
 {
+	if (can_reference (frame)) {
+		_frame = av_frame_clone (frame);
+		if (!_frame) {
+			throw bad_alloc ();
+		}
+
+		allocate_arrays ();
+		for (int i = 0; i < planes(); ++i) {
+			_data[i] = _frame->data[i];
+			_line_size[i] = ceil (_size.width * bytes_per_pixel(i));
+			/* AVFrame's linesize is what we call `stride' */
+			_stride[i] = _frame->linesize[i];
+		}
+		return;
+	}
+
 	allocate ();
 
 	for (int i = 0; i < planes(); ++i) {
@@ -781,6 +949,7 @@ Image::Image (shared_ptr<const Image> other, bool aligned)
 	, _pixel_format (other->_pixel_format)
 	, _aligned (aligned)
 	, _extra_pixels (other->_extra_pixels)
+	, _frame (0)
 {
 	allocate ();
 
@@ -823,13 +992,63 @@ Image::swap (Image & other)
 
 	std::swap (_aligned, other._aligned);
 	std::swap (_extra_pixels, other._extra_pixels);
+	std::swap (_frame, other._frame);
+}
+
+/** @return true if we can use the data in a frame without copying it */
+bool
+Image::can_reference (AVFrame const * frame) const
+{
+	/* We can only hold on to data which is reference-counted, and to keep things
+	   simple we don't bother with frames which have more than AV_NUM_DATA_POINTERS buffers.
+	*/
+	if (!frame->buf[0] || frame->nb_extended_buf > 0) {
+		return false;
+	}
+
+	/* The data must also meet the same alignment requirements as the data that we
+	   allocate; this also rules out negative linesizes.
+	*/
+	for (int i = 0; i < planes(); ++i) {
+		if (!frame->data[i] || (reinterpret_cast<uintptr_t> (frame->data[i]) % 16) != 0 || frame->linesize[i] <= 0 || (frame->linesize[i] % 32) != 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/** Make sure that our data can be written to without affecting anything else.
+ *  This copies the data if we are using an AVFrame's buffers which something
+ *  else also has a reference to.  It is called by all the methods which modify
+ *  the image; anything which writes to data() directly on an Image that it did not
+ *  create should call it first.
+ */
+void
+Image::make_writable ()
+{
+	if (!_frame) {
+		return;
+	}
+
+	for (int i = 0; i < AV_NUM_DATA_POINTERS; ++i) {
+		if (_frame->buf[i] && !av_buffer_is_writable (_frame->buf[i])) {
+			Image copy (*this);
+			swap (copy);
+			return;
+		}
+	}
 }
 
 /** Destroy a Image */
 Image::~Image ()
 {
-	for (int i = 0; i < planes(); ++i) {
-		av_free (_data[i]);
+	if (_frame) {
+		av_frame_free (&_frame);
+	} else {
+		for (int i = 0; i < planes(); ++i) {
+			ImageBufferPool::instance()->put (_data[i], plane_allocation (i));
+		}
 	}
 
 	av_free (_data);
@@ -867,31 +1086,6 @@ Image::aligned () const
 	return _aligned;
 }
 
-PositionImage
-merge (list<PositionImage> images)
-{
-	if (images.empty ()) {
-		return PositionImage ();
-	}
-
-	if (images.size() == 1) {
-		return images.front ();
-	}
-
-	dcpomatic::Rect<int> all (images.front().position, images.front().image->size().width, images.front().image->size().height);
-	for (list<PositionImage>::const_iterator i = images.begin(); i != images.end(); ++i) {
-		all.extend (dcpomatic::Rect<int> (i->position, i->image->size().width, i->image->size().height));
-	}
-
-	shared_ptr<Image> merged (new Image (images.front().image->pixel_format (), dcp::Size (all.width, all.height), true));
-	merged->make_transparent ();
-	for (list<PositionImage>::const_iterator i = images.begin(); i != images.end(); ++i) {
-		merged->alpha_blend (i->image, i->position - all.position());
-	}
-
-	return PositionImage (merged, all.position ());
-}
-
 bool
 operator== (Image const & a, Image const & b)
 {
@@ -926,6 +1120,10 @@ operator== (Image const & a, Image const & b)
 void
 Image::fade (float f)
 {
+	make_writable ();
+
+	SIMDLevel const level = simd_level ();
+
 	switch (_pixel_format) {
 	case AV_PIX_FMT_YUV420P:
 	case AV_PIX_FMT_YUV422P:
@@ -945,11 +1143,7 @@ Image::fade (float f)
 			uint8_t* p = data()[c];
 			int const lines = sample_size(c).height;
 			for (int y = 0; y < lines; ++y) {
-				uint8_t* q = p;
-				for (int x = 0; x < line_size()[c]; ++x) {
-					*q = int (float (*q) * f);
-					++q;
-				}
+				fade_row_8 (p, line_size()[c], f, level);
 				p += stride()[c];
 			}
 		}
@@ -971,17 +1165,11 @@ Image::fade (float f)
 	case AV_PIX_FMT_XYZ12LE:
 		/* 16-bit little-endian */
 		for (int c = 0; c < 3; ++c) {
-			int const stride_pixels = stride()[c] / 2;
-			int const line_size_pixels = line_size()[c] / 2;
-			uint16_t* p = reinterpret_cast<uint16_t*> (data()[c]);
+			uint8_t* p = data()[c];
 			int const lines = sample_size(c).height;
 			for (int y = 0; y < lines; ++y) {
-				uint16_t* q = p;
-				for (int x = 0; x < line_size_pixels; ++x) {
-					*q = int (float (*q) * f);
-					++q;
-				}
-				p += stride_pixels;
+				fade_row_16le (reinterpret_cast<uint16_t*> (p), line_size()[c] / 2, f, level);
+				p += stride()[c];
 			}
 		}
 		break;
@@ -1002,17 +1190,11 @@ Image::fade (float f)
 	case AV_PIX_FMT_RGB48BE:
 		/* 16-bit big-endian */
 		for (int c = 0; c < 3; ++c) {
-			int const stride_pixels = stride()[c] / 2;
-			int const line_size_pixels = line_size()[c] / 2;
-			uint16_t* p = reinterpret_cast<uint16_t*> (data()[c]);
+			uint8_t* p = data()[c];
 			int const lines = sample_size(c).height;
 			for (int y = 0; y < lines; ++y) {
-				uint16_t* q = p;
-				for (int x = 0; x < line_size_pixels; ++x) {
-					*q = swap_16 (int (float (swap_16 (*q)) * f));
-					++q;
-				}
-				p += stride_pixels;
+				fade_row_16be (reinterpret_cast<uint16_t*> (p), line_size()[c] / 2, f, level);
+				p += stride()[c];
 			}
 		}
 		break;
@@ -1023,10 +1205,8 @@ Image::fade (float f)
 		int const X = line_size()[0];
 		uint8_t* p = data()[0];
 		for (int y = 0; y < Y; ++y) {
-			for (int x = 0; x < X; ++x) {
-				*p = int (float (*p) * f);
-				++p;
-			}
+			fade_row_8 (p, X, f, level);
+			p += stride()[0];
 		}
 		break;
 	}
@@ -64,6 +64,7 @@ public:
 		Crop crop, dcp::Size inter_size, dcp::Size out_size, dcp::YUVToRGB yuv_to_rgb, AVPixelFormat out_format, bool aligned, bool fast
 		) const;
 
+	void make_writable ();
 	void make_black ();
 	void make_transparent ();
 	void alpha_blend (boost::shared_ptr<const Image> image, Position<int> pos);
@@ -82,7 +83,11 @@ public:
 private:
 	friend struct pixel_formats_test;
 
+	void allocate_arrays ();
 	void allocate ();
+	size_t plane_allocation (int i) const;
+	bool can_reference (AVFrame const * frame) const;
+	boost::shared_ptr<Image> xyz_to_rgb24_preview (Crop crop) const;
 	void swap (Image &);
 	void yuv_16_black (uint16_t, bool);
 	static uint16_t swap_16 (uint16_t);
@@ -94,9 +99,10 @@ private:
 	int* _stride; ///< array of strides for each line, in bytes (including any alignment padding bytes)
 	bool _aligned;
 	int _extra_pixels;
+	/** frame whose buffers hold our data, or 0 if we allocated the data ourselves */
+	AVFrame* _frame;
 };
 
-extern PositionImage merge (std::list<PositionImage> images);
 extern bool operator== (Image const & a, Image const & b);
 
 #endif
@@ -0,0 +1,174 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "image_buffer_pool.h"
+#include "util.h"
+extern "C" {
+#include <libavutil/mem.h>
+}
+
+using std::list;
+using std::pair;
+using std::make_pair;
+using std::max;
+
+ImageBufferPool* ImageBufferPool::_instance = 0;
+
+ImageBufferPool::ImageBufferPool ()
+	: _max_idle_bytes (1024 * 1024 * 1024)
+	, _max_idle_buffers (256)
+{
+
+}
+
+ImageBufferPool::~ImageBufferPool ()
+{
+	clear ();
+}
+
+/** @param size Size of a request in bytes.
+ *  @return Size of buffer that will be allocated for the request; this is
+ *  rounded up so that no more than 1/8 of any buffer is wasted,
+ *  with a minimum granularity of 4k.
+ */
+size_t
+ImageBufferPool::size_class (size_t size)
+{
+	size_t granularity = 4096;
+	while (granularity * 16 <= size) {
+		granularity *= 2;
+	}
+	return ((size + granularity - 1) / granularity) * granularity;
+}
+
+/** @param size Required size in bytes.
+ *  @return A buffer of at least size bytes, aligned as av_malloc would align it.
+ *  It must be given back with put(), passing the same size.
+ */
+uint8_t *
+ImageBufferPool::get (size_t size)
+{
+	size_t const c = size_class (size);
+
+	{
+		boost::mutex::scoped_lock lm (_mutex);
+		for (list<pair<size_t, uint8_t*> >::iterator i = _idle.begin(); i != _idle.end(); ++i) {
+			if (i->first == c) {
+				uint8_t* b = i->second;
+				_idle.erase (i);
+				++_statistics.reuses;
+				--_statistics.idle_buffers;
+				_statistics.idle_bytes -= c;
+				_statistics.in_use_bytes += c;
+				return b;
+			}
+		}
+	}
+
+	uint8_t* b = static_cast<uint8_t*> (wrapped_av_malloc (c));
+
+	boost::mutex::scoped_lock lm (_mutex);
+	++_statistics.allocations;
+	_statistics.in_use_bytes += c;
+	_statistics.peak_bytes = max (_statistics.peak_bytes, _statistics.in_use_bytes + _statistics.idle_bytes);
+	return b;
+}
+
+/** Give back a buffer that was obtained with get().
+ *  @param buffer Buffer.
+ *  @param size Size that was passed to get().
+ */
+void
+ImageBufferPool::put (uint8_t* buffer, size_t size)
+{
+	if (!buffer) {
+		return;
+	}
+
+	size_t const c = size_class (size);
+
+	boost::mutex::scoped_lock lm (_mutex);
+	_statistics.in_use_bytes -= c;
+	_idle.push_front (make_pair (c, buffer));
+	++_statistics.idle_buffers;
+	_statistics.idle_bytes += c;
+	trim ();
+}
+
+/** Free idle buffers, least recently used first, until we are within our limits.
+ *  Must be called with _mutex held.
+ */
+void
+ImageBufferPool::trim ()
+{
+	while (!_idle.empty() && (_statistics.idle_bytes > _max_idle_bytes || _statistics.idle_buffers > _max_idle_buffers)) {
+		av_free (_idle.back().second);
+		_statistics.idle_bytes -= _idle.back().first;
+		--_statistics.idle_buffers;
+		++_statistics.frees;
+		_idle.pop_back ();
+	}
+}
+
+/** Set the limits on how much memory the pool will keep when it is not being used.
+ *  @param max_idle_bytes Maximum total size of idle buffers in bytes.
+ *  @param max_idle_buffers Maximum number of idle buffers.
+ */
+void
+ImageBufferPool::set_limits (int64_t max_idle_bytes, int max_idle_buffers)
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	_max_idle_bytes = max_idle_bytes;
+	_max_idle_buffers = max_idle_buffers;
+	trim ();
+}
+
+/** Free all idle buffers */
+void
+ImageBufferPool::clear ()
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	for (list<pair<size_t, uint8_t*> >::iterator i = _idle.begin(); i != _idle.end(); ++i) {
+		av_free (i->second);
+		++_statistics.frees;
+	}
+	_idle.clear ();
+	_statistics.idle_buffers = 0;
+	_statistics.idle_bytes = 0;
+}
+
+ImageBufferPool::Statistics
+ImageBufferPool::statistics () const
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	return _statistics;
+}
+
+ImageBufferPool *
+ImageBufferPool::instance ()
+{
+	static boost::mutex instance_mutex;
+	boost::mutex::scoped_lock lm (instance_mutex);
+	if (!_instance) {
+		_instance = new ImageBufferPool ();
+	}
+
+	return _instance;
+}
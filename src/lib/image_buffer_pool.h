@@ -0,0 +1,96 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DCPOMATIC_IMAGE_BUFFER_POOL_H
+#define DCPOMATIC_IMAGE_BUFFER_POOL_H
+
+#include <boost/thread/mutex.hpp>
+#include <boost/noncopyable.hpp>
+#include <list>
+#include <stdint.h>
+
+/** @class ImageBufferPool
+ *  @brief A pool of memory for Image planes, so that we need not go back to
+ *  the allocator (and the kernel) for every plane of every frame.
+ *
+ *  Requests are rounded up to a size class so that buffers for images of
+ *  similar (as well as identical) sizes can be re-used.  Buffers which are given
+ *  back are kept, up to some limits, and handed out again by later requests
+ *  in the same class.
+ */
+class ImageBufferPool : public boost::noncopyable
+{
+public:
+	struct Statistics
+	{
+		Statistics ()
+			: allocations (0)
+			, reuses (0)
+			, frees (0)
+			, idle_buffers (0)
+			, idle_bytes (0)
+			, in_use_bytes (0)
+			, peak_bytes (0)
+		{}
+
+		/** number of buffers that have been allocated from the system */
+		int64_t allocations;
+		/** number of requests that were satisfied by an idle buffer */
+		int64_t reuses;
+		/** number of buffers that have been given back to the system */
+		int64_t frees;
+		/** number of buffers currently idle in the pool */
+		int64_t idle_buffers;
+		/** number of bytes currently idle in the pool */
+		int64_t idle_bytes;
+		/** number of bytes currently held by callers */
+		int64_t in_use_bytes;
+		/** highest value that idle_bytes + in_use_bytes has reached */
+		int64_t peak_bytes;
+	};
+
+	uint8_t* get (size_t size);
+	void put (uint8_t* buffer, size_t size);
+
+	void set_limits (int64_t max_idle_bytes, int max_idle_buffers);
+	void clear ();
+	Statistics statistics () const;
+
+	static size_t size_class (size_t size);
+
+	static ImageBufferPool* instance ();
+
+private:
+	ImageBufferPool ();
+	~ImageBufferPool ();
+
+	void trim ();
+
+	mutable boost::mutex _mutex;
+	/** buffers which are not in use, with their size classes; most recently used first */
+	std::list<std::pair<size_t, uint8_t*> > _idle;
+	int64_t _max_idle_bytes;
+	int _max_idle_buffers;
+	Statistics _statistics;
+
+	static ImageBufferPool* _instance;
+};
+
+#endif
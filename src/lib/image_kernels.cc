@@ -0,0 +1,696 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/** @file  src/lib/image_kernels.cc
+ *  @brief Inner loops of some Image operations, with versions for different instruction sets.
+ *
+ *  Each kernel is written once as a simple integer loop (the "body") which the
+ *  compiler can vectorise.  DCPOMATIC_KERNEL (from simd.h) then makes a plain
+ *  version and versions compiled for SSE2 and AVX2; the caller says which one to use.
+ */
+
+#include "image_kernels.h"
+#include "dcpomatic_assert.h"
+#include <dcp/colour_conversion.h>
+#include <dcp/rgb_xyz.h>
+#include <dcp/transfer_function.h>
+#include <algorithm>
+#include <cmath>
+
+using std::min;
+using std::max;
+
+/** @return x / 255, for 0 <= x <= 65534, without a division */
+static DCPOMATIC_KERNEL_INLINE int
+div255 (int x)
+{
+	return (x + 1 + (x >> 8)) >> 8;
+}
+
+/** Blend an 8-bit overlay value o onto a target value t using alpha a (0-255) */
+static DCPOMATIC_KERNEL_INLINE uint8_t
+blend8 (int o, int t, int a)
+{
+	return div255 (o * a + t * (255 - a));
+}
+
+/* Alpha-blending; the overlay is always BGRA, 8 bits per component */
+
+static DCPOMATIC_KERNEL_INLINE void
+alpha_blend_rgb24_body (uint8_t* __restrict t, uint8_t const * __restrict o, int pixels)
+{
+	for (int i = 0; i < pixels; ++i) {
+		int const a = o[3];
+		t[0] = blend8 (o[2], t[0], a);
+		t[1] = blend8 (o[1], t[1], a);
+		t[2] = blend8 (o[0], t[2], a);
+		t += 3;
+		o += 4;
+	}
+}
+
+DCPOMATIC_KERNEL (
+	alpha_blend_rgb24,
+	(uint8_t* __restrict t, uint8_t const * __restrict o, int pixels),
+	(t, o, pixels)
+	)
+
+static DCPOMATIC_KERNEL_INLINE void
+alpha_blend_rgba_body (uint8_t* __restrict t, uint8_t const * __restrict o, int pixels)
+{
+	for (int i = 0; i < pixels; ++i) {
+		int const a = o[3];
+		t[0] = blend8 (o[0], t[0], a);
+		t[1] = blend8 (o[1], t[1], a);
+		t[2] = blend8 (o[2], t[2], a);
+		t[3] = blend8 (o[3], t[3], a);
+		t += 4;
+		o += 4;
+	}
+}
+
+DCPOMATIC_KERNEL (
+	alpha_blend_rgba,
+	(uint8_t* __restrict t, uint8_t const * __restrict o, int pixels),
+	(t, o, pixels)
+	)
+
+/** Blend an 8-bit overlay value o onto the high byte of a 16-bit target value t using alpha a */
+static DCPOMATIC_KERNEL_INLINE uint16_t
+blend8_high (int o, int t, int a)
+{
+	return (t & 0xff) | (blend8 (o, t >> 8, a) << 8);
+}
+
+static DCPOMATIC_KERNEL_INLINE void
+alpha_blend_rgb48le_body (uint16_t* __restrict t, uint8_t const * __restrict o, int pixels)
+{
+	for (int i = 0; i < pixels; ++i) {
+		int const a = o[3];
+		t[0] = blend8_high (o[2], t[0], a);
+		t[1] = blend8_high (o[1], t[1], a);
+		t[2] = blend8_high (o[0], t[2], a);
+		t += 3;
+		o += 4;
+	}
+}
+
+DCPOMATIC_KERNEL (
+	alpha_blend_rgb48le,
+	(uint16_t* __restrict t, uint8_t const * __restrict o, int pixels),
+	(t, o, pixels)
+	)
+
+/** Look-up tables to convert sRGB overlay pixels to 12-bit XYZ.  The RGB to XYZ
+ *  matrix is folded into the input tables so that each of X, Y and Z is the
+ *  sum of three look-ups, calculated in the same order as dcp::rgb_to_xyz.
+ */
+struct XYZBlendTables
+{
+	XYZBlendTables ()
+	{
+		dcp::ColourConversion conv = dcp::ColourConversion::srgb_to_xyz ();
+		double matrix[9];
+		dcp::combined_rgb_to_xyz (conv, matrix);
+		double const * lut_in = conv.in()->lut (8, false);
+		double const * lut_out = conv.out()->lut (16, true);
+
+		for (int i = 0; i < 256; ++i) {
+			for (int j = 0; j < 9; ++j) {
+				in[j][i] = lut_in[i] * matrix[j];
+			}
+		}
+
+		for (int i = 0; i < 65536; ++i) {
+			out[i] = lrint (lut_out[i] * 65535);
+		}
+	}
+
+	/** in[n][v] is the contribution of input value v to the output component n / 3
+	 *  via matrix element n.
+	 */
+	double in[9][256];
+	uint16_t out[65536];
+};
+
+static XYZBlendTables const &
+xyz_blend_tables ()
+{
+	static XYZBlendTables tables;
+	return tables;
+}
+
+static DCPOMATIC_KERNEL_INLINE void
+alpha_blend_xyz12le_body (uint16_t* __restrict t, uint8_t const * __restrict o, int pixels, XYZBlendTables const * __restrict tables)
+{
+	for (int i = 0; i < pixels; ++i) {
+		int const a = o[3];
+		/* o is BGRA */
+		int const r = o[2];
+		int const g = o[1];
+		int const b = o[0];
+
+		double const x = max (0.0, min (65535.0, tables->in[0][r] + tables->in[1][g] + tables->in[2][b]));
+		double const y = max (0.0, min (65535.0, tables->in[3][r] + tables->in[4][g] + tables->in[5][b]));
+		double const z = max (0.0, min (65535.0, tables->in[6][r] + tables->in[7][g] + tables->in[8][b]));
+
+		/* The blend needs up to 65535 * 255, so we can't use div255 here */
+		t[0] = (tables->out[lrint(x)] * a + t[0] * (255 - a)) / 255;
+		t[1] = (tables->out[lrint(y)] * a + t[1] * (255 - a)) / 255;
+		t[2] = (tables->out[lrint(z)] * a + t[2] * (255 - a)) / 255;
+
+		t += 3;
+		o += 4;
+	}
+}
+
+DCPOMATIC_KERNEL (
+	alpha_blend_xyz12le,
+	(uint16_t* __restrict t, uint8_t const * __restrict o, int pixels, XYZBlendTables const * __restrict tables),
+	(t, o, pixels, tables)
+	)
+
+/** @return true if alpha_blend_row() can handle a given target pixel format */
+bool
+alpha_blend_row_supported (AVPixelFormat format)
+{
+	switch (format) {
+	case AV_PIX_FMT_RGB24:
+	case AV_PIX_FMT_BGRA:
+	case AV_PIX_FMT_RGBA:
+	case AV_PIX_FMT_RGB48LE:
+	case AV_PIX_FMT_XYZ12LE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/** Blend a row of BGRA pixels onto a row of pixels in some other format.
+ *  @param format Format of target.
+ *  @param target First pixel to write to.
+ *  @param overlay First BGRA pixel to blend.
+ *  @param pixels Number of pixels to blend.
+ *  @param level Instruction set to use.
+ */
+void
+alpha_blend_row (AVPixelFormat format, uint8_t* target, uint8_t const * overlay, int pixels, SIMDLevel level)
+{
+	switch (format) {
+	case AV_PIX_FMT_RGB24:
+		DCPOMATIC_KERNEL_CALL (alpha_blend_rgb24, level, (target, overlay, pixels));
+		break;
+	case AV_PIX_FMT_BGRA:
+	case AV_PIX_FMT_RGBA:
+		DCPOMATIC_KERNEL_CALL (alpha_blend_rgba, level, (target, overlay, pixels));
+		break;
+	case AV_PIX_FMT_RGB48LE:
+	{
+		/* This assumes that we are on a little-endian machine */
+		uint16_t* t = reinterpret_cast<uint16_t*> (target);
+		DCPOMATIC_KERNEL_CALL (alpha_blend_rgb48le, level, (t, overlay, pixels));
+		break;
+	}
+	case AV_PIX_FMT_XYZ12LE:
+	{
+		XYZBlendTables const * tables = &xyz_blend_tables ();
+		uint16_t* t = reinterpret_cast<uint16_t*> (target);
+		DCPOMATIC_KERNEL_CALL (alpha_blend_xyz12le, level, (t, overlay, pixels, tables));
+		break;
+	}
+	default:
+		DCPOMATIC_ASSERT (false);
+	}
+}
+
+/* Fading; each sample v becomes v * f, with f represented as m / 2^bits */
+
+static DCPOMATIC_KERNEL_INLINE void
+fade_8_body (uint8_t* __restrict p, int samples, int m)
+{
+	for (int i = 0; i < samples; ++i) {
+		p[i] = (p[i] * m) >> 8;
+	}
+}
+
+DCPOMATIC_KERNEL (
+	fade_8,
+	(uint8_t* __restrict p, int samples, int m),
+	(p, samples, m)
+	)
+
+static DCPOMATIC_KERNEL_INLINE void
+fade_16le_body (uint16_t* __restrict p, int samples, uint32_t m)
+{
+	for (int i = 0; i < samples; ++i) {
+		p[i] = (p[i] * m) >> 16;
+	}
+}
+
+DCPOMATIC_KERNEL (
+	fade_16le,
+	(uint16_t* __restrict p, int samples, uint32_t m),
+	(p, samples, m)
+	)
+
+static DCPOMATIC_KERNEL_INLINE uint16_t
+swap16 (uint16_t v)
+{
+	return (v >> 8) | (v << 8);
+}
+
+static DCPOMATIC_KERNEL_INLINE void
+fade_16be_body (uint16_t* __restrict p, int samples, uint32_t m)
+{
+	for (int i = 0; i < samples; ++i) {
+		p[i] = swap16 ((swap16 (p[i]) * m) >> 16);
+	}
+}
+
+DCPOMATIC_KERNEL (
+	fade_16be,
+	(uint16_t* __restrict p, int samples, uint32_t m),
+	(p, samples, m)
+	)
+
+/** @param f Fade factor, 0 for black and 1 for no change.
+ *  @param bits Number of fractional bits to use.
+ *  @return f as a fixed-point value with the given number of fractional bits.
+ */
+static int
+fade_multiplier (float f, int bits)
+{
+	return lrint (max (0.0f, min (1.0f, f)) * (1 << bits));
+}
+
+/** Fade a row of 8-bit samples.
+ *  @param data First sample.
+ *  @param samples Number of samples.
+ *  @param f Fade factor, 0 for black and 1 for no change.
+ *  @param level Instruction set to use.
+ */
+void
+fade_row_8 (uint8_t* data, int samples, float f, SIMDLevel level)
+{
+	int const m = fade_multiplier (f, 8);
+	if (m == (1 << 8)) {
+		return;
+	}
+	DCPOMATIC_KERNEL_CALL (fade_8, level, (data, samples, m));
+}
+
+/** Fade a row of 16-bit little-endian samples; parameters are as for fade_row_8 */
+void
+fade_row_16le (uint16_t* data, int samples, float f, SIMDLevel level)
+{
+	int const m = fade_multiplier (f, 16);
+	if (m == (1 << 16)) {
+		return;
+	}
+	/* This assumes that we are on a little-endian machine */
+	DCPOMATIC_KERNEL_CALL (fade_16le, level, (data, samples, m));
+}
+
+/** Fade a row of 16-bit big-endian samples; parameters are as for fade_row_8 */
+void
+fade_row_16be (uint16_t* data, int samples, float f, SIMDLevel level)
+{
+	int const m = fade_multiplier (f, 16);
+	if (m == (1 << 16)) {
+		return;
+	}
+	DCPOMATIC_KERNEL_CALL (fade_16be, level, (data, samples, m));
+}
+
+/** Look-up tables and matrix to convert 12-bit XYZ to 8-bit RGB for previews.
+ *  These do the same job as swscale's conversion from XYZ (DCI gamma 2.6 in, the
+ *  XYZ to sRGB matrix and then gamma 2.2 out) but the matrix is applied in floating
+ *  point rather than to 12-bit integers, since its large negative elements make
+ *  small errors in the linear values show up badly in dark colours.
+ */
+struct XYZPreviewTables
+{
+	XYZPreviewTables ()
+	{
+		double const xyz_to_rgb[9] = {
+			3.2404542, -1.5371385, -0.4985314,
+			-0.9692660, 1.8760108, 0.0415560,
+			0.0556434, -0.2040259, 1.0572252
+		};
+
+		for (int i = 0; i < 4096; ++i) {
+			in[i] = pow (i / 4095.0, 2.6);
+		}
+
+		/* Scale the matrix so that its results are 16-bit */
+		for (int i = 0; i < 9; ++i) {
+			matrix[i] = xyz_to_rgb[i] * 65535;
+		}
+
+		for (int i = 0; i < 65536; ++i) {
+			out[i] = lrint (pow (i / 65535.0, 1 / 2.2) * 255);
+		}
+	}
+
+	/** linear value (0 to 1) for each 12-bit XYZ value */
+	float in[4096];
+	/** XYZ to RGB matrix, scaled by 65535 */
+	float matrix[9];
+	/** 8-bit RGB value for each linear 16-bit value */
+	int out[65536];
+};
+
+static XYZPreviewTables const &
+xyz_preview_tables ()
+{
+	static XYZPreviewTables tables;
+	return tables;
+}
+
+/** @return v rounded to the nearest integer and clamped to [0, 65535], for v > -2^31 */
+static DCPOMATIC_KERNEL_INLINE int
+round_clamp_16 (float v)
+{
+	/* int() rounds towards zero, which is wrong for negative v, but they are clamped to 0 anyway */
+	int const i = int (v + 0.5f);
+	return i < 0 ? 0 : (i > 65535 ? 65535 : i);
+}
+
+static DCPOMATIC_KERNEL_INLINE void
+xyz12le_to_rgb24_body (uint16_t const * __restrict p, uint8_t* __restrict q, int pixels, XYZPreviewTables const * __restrict tables)
+{
+	float const m0 = tables->matrix[0];
+	float const m1 = tables->matrix[1];
+	float const m2 = tables->matrix[2];
+	float const m3 = tables->matrix[3];
+	float const m4 = tables->matrix[4];
+	float const m5 = tables->matrix[5];
+	float const m6 = tables->matrix[6];
+	float const m7 = tables->matrix[7];
+	float const m8 = tables->matrix[8];
+
+	for (int i = 0; i < pixels; ++i) {
+		/* The 12 bits of each sample are in the top of its 16 */
+		float const x = tables->in[p[i * 3] >> 4];
+		float const y = tables->in[p[i * 3 + 1] >> 4];
+		float const z = tables->in[p[i * 3 + 2] >> 4];
+
+		q[i * 3] = tables->out[round_clamp_16 (x * m0 + y * m1 + z * m2)];
+		q[i * 3 + 1] = tables->out[round_clamp_16 (x * m3 + y * m4 + z * m5)];
+		q[i * 3 + 2] = tables->out[round_clamp_16 (x * m6 + y * m7 + z * m8)];
+	}
+}
+
+DCPOMATIC_KERNEL (
+	xyz12le_to_rgb24,
+	(uint16_t const * __restrict p, uint8_t* __restrict q, int pixels, XYZPreviewTables const * __restrict tables),
+	(p, q, pixels, tables)
+	)
+
+/** Convert a row of XYZ12LE pixels to RGB24 quickly, for previews.  The results are
+ *  within 1 of a precise conversion using the same transfer functions and matrix as
+ *  swscale uses for XYZ input.
+ *  @param xyz First XYZ12LE pixel.
+ *  @param rgb First RGB24 pixel to write to.
+ *  @param pixels Number of pixels.
+ *  @param level Instruction set to use.
+ */
+void
+xyz12le_to_rgb24_row (uint16_t const * xyz, uint8_t* rgb, int pixels, SIMDLevel level)
+{
+	XYZPreviewTables const * tables = &xyz_preview_tables ();
+	/* This assumes that we are on a little-endian machine */
+	DCPOMATIC_KERNEL_CALL (xyz12le_to_rgb24, level, (xyz, rgb, pixels, tables));
+}
+
+/* YUV to RGB48LE; the YUV is limited-range and planar, and the chroma is
+   upsampled in the same way as swscale does it when it is not scaling:
+   subsampled chroma is shared by each horizontal pair of pixels, and vertically
+   it is interpolated from the rows either side, sited midway between two luma rows.
+*/
+
+/** Coefficients for a YUV to RGB48 conversion, set up for samples of a particular bit depth */
+struct YUVToRGB48Coefficients
+{
+	YUVToRGB48Coefficients (dcp::YUVToRGB yuv_to_rgb, int bits)
+	{
+		/* Luma weights of red and blue */
+		double const kr = yuv_to_rgb == dcp::YUV_TO_RGB_REC709 ? 0.2126 : 0.299;
+		double const kb = yuv_to_rgb == dcp::YUV_TO_RGB_REC709 ? 0.0722 : 0.114;
+		double const kg = 1 - kr - kb;
+
+		/* Limited range is 16-235 for luma and 16-240 for chroma, at 8 bits */
+		double const shift = 1 << (bits - 8);
+		double const y_range = 219 * shift;
+		double const c_range = 224 * shift;
+
+		y_offset = 16 * shift;
+		c_offset = 128 * shift;
+		y_scale = 65535 / y_range;
+		cr_r = 65535 * 2 * (1 - kr) / c_range;
+		cb_g = 65535 * 2 * (1 - kb) * kb / (kg * c_range);
+		cr_g = 65535 * 2 * (1 - kr) * kr / (kg * c_range);
+		cb_b = 65535 * 2 * (1 - kb) / c_range;
+	}
+
+	float y_offset;
+	float c_offset;
+	float y_scale;
+	float cr_r;
+	float cb_g;
+	float cr_g;
+	float cb_b;
+};
+
+/** One row of a YUV to RGB48 conversion */
+template <class T>
+struct YUVRow
+{
+	/** first luma sample to convert */
+	T const * y;
+	/** the chroma rows either side of the luma row, starting at the chroma sample for y[0] */
+	T const * u[2];
+	T const * v[2];
+	/** weight to give to u[1] and v[1] */
+	float weight;
+	/** 1 if the chroma is horizontally subsampled, otherwise 0 */
+	int log2_chroma_w;
+	/** true if y[0] shares its chroma sample with the pixel to its left */
+	bool odd;
+};
+
+/** Number of pixels that yuv_to_rgb48le_body does at a time */
+static int const yuv_to_rgb48le_chunk = 256;
+
+template <class T>
+static DCPOMATIC_KERNEL_INLINE void
+yuv_to_rgb48le_body (YUVRow<T> const & row, uint16_t* __restrict q, int pixels, YUVToRGB48Coefficients const & k)
+{
+	T const * __restrict y = row.y;
+	T const * __restrict u0 = row.u[0];
+	T const * __restrict u1 = row.u[1];
+	T const * __restrict v0 = row.v[0];
+	T const * __restrict v1 = row.v[1];
+	float const w1 = row.weight;
+	float const w0 = 1 - w1;
+	float const y_offset = k.y_offset;
+	float const y_scale = k.y_scale;
+	float const c_offset = k.c_offset;
+	float const cr_r = k.cr_r;
+	float const cb_g = k.cb_g;
+	float const cr_g = k.cr_g;
+	float const cb_b = k.cb_b;
+
+	/* Chroma for each pixel of a chunk; when the chroma is subsampled, pixel i's
+	   is at [i + odd] so that each pair of pixels starts at an even index.
+	*/
+	float cb[yuv_to_rgb48le_chunk + 2];
+	float cr[yuv_to_rgb48le_chunk + 2];
+	int const odd = row.odd ? 1 : 0;
+
+	for (int start = 0; start < pixels; start += yuv_to_rgb48le_chunk) {
+		int const n = min (yuv_to_rgb48le_chunk, pixels - start);
+
+		int o = 0;
+		if (row.log2_chroma_w == 0) {
+			T const * __restrict u0c = u0 + start;
+			T const * __restrict u1c = u1 + start;
+			T const * __restrict v0c = v0 + start;
+			T const * __restrict v1c = v1 + start;
+			for (int i = 0; i < n; ++i) {
+				cb[i] = u0c[i] * w0 + u1c[i] * w1 - c_offset;
+				cr[i] = v0c[i] * w0 + v1c[i] * w1 - c_offset;
+			}
+		} else {
+			/* start is even, so the first chroma sample of this chunk is at start / 2 */
+			o = odd;
+			T const * __restrict u0c = u0 + start / 2;
+			T const * __restrict u1c = u1 + start / 2;
+			T const * __restrict v0c = v0 + start / 2;
+			T const * __restrict v1c = v1 + start / 2;
+			int const samples = (n + o + 1) / 2;
+			for (int i = 0; i < samples; ++i) {
+				float const b = u0c[i] * w0 + u1c[i] * w1 - c_offset;
+				float const r = v0c[i] * w0 + v1c[i] * w1 - c_offset;
+				cb[i * 2] = b;
+				cb[i * 2 + 1] = b;
+				cr[i * 2] = r;
+				cr[i * 2 + 1] = r;
+			}
+		}
+
+		T const * __restrict yc = y + start;
+		uint16_t* __restrict qc = q + start * 3;
+		float const * __restrict cbc = cb + o;
+		float const * __restrict crc = cr + o;
+		for (int i = 0; i < n; ++i) {
+			float const l = (yc[i] - y_offset) * y_scale;
+			qc[i * 3] = round_clamp_16 (l + crc[i] * cr_r);
+			qc[i * 3 + 1] = round_clamp_16 (l - cbc[i] * cb_g - crc[i] * cr_g);
+			qc[i * 3 + 2] = round_clamp_16 (l + cbc[i] * cb_b);
+		}
+	}
+}
+
+static DCPOMATIC_KERNEL_INLINE void
+yuv8_to_rgb48le_body (YUVRow<uint8_t> const & row, uint16_t* q, int pixels, YUVToRGB48Coefficients const & k)
+{
+	yuv_to_rgb48le_body (row, q, pixels, k);
+}
+
+static DCPOMATIC_KERNEL_INLINE void
+yuv16_to_rgb48le_body (YUVRow<uint16_t> const & row, uint16_t* q, int pixels, YUVToRGB48Coefficients const & k)
+{
+	yuv_to_rgb48le_body (row, q, pixels, k);
+}
+
+DCPOMATIC_KERNEL (
+	yuv8_to_rgb48le,
+	(YUVRow<uint8_t> const & row, uint16_t* q, int pixels, YUVToRGB48Coefficients const & k),
+	(row, q, pixels, k)
+	)
+
+DCPOMATIC_KERNEL (
+	yuv16_to_rgb48le,
+	(YUVRow<uint16_t> const & row, uint16_t* q, int pixels, YUVToRGB48Coefficients const & k),
+	(row, q, pixels, k)
+	)
+
+/** Set up a YUVRow for a row of an image.
+ *  @param data Image planes.
+ *  @param stride Image strides in bytes.
+ *  @param height Image height in pixels.
+ *  @param log2_chroma_h 1 if the chroma is vertically subsampled, otherwise 0.
+ *  @param x First pixel to convert.
+ *  @param y Row to convert.
+ */
+template <class T>
+static YUVRow<T>
+yuv_row (uint8_t const * const * data, int const * stride, int height, int log2_chroma_w, int log2_chroma_h, int x, int y)
+{
+	YUVRow<T> row;
+	row.y = reinterpret_cast<T const *> (data[0] + y * stride[0]) + x;
+	row.log2_chroma_w = log2_chroma_w;
+	row.odd = (x & log2_chroma_w) != 0;
+
+	int c[2] = { y, y };
+	row.weight = 0;
+	if (log2_chroma_h) {
+		/* Chroma row k lies between luma rows 2k and 2k + 1, so the nearest chroma
+		   row gets 3/4 of the weight and the next-nearest 1/4.
+		*/
+		int const chroma_height = (height + 1) / 2;
+		c[0] = y / 2;
+		c[1] = max (0, min (chroma_height - 1, (y & 1) ? c[0] + 1 : c[0] - 1));
+		row.weight = 0.25;
+	}
+
+	for (int i = 0; i < 2; ++i) {
+		row.u[i] = reinterpret_cast<T const *> (data[1] + c[i] * stride[1]) + (x >> log2_chroma_w);
+		row.v[i] = reinterpret_cast<T const *> (data[2] + c[i] * stride[2]) + (x >> log2_chroma_w);
+	}
+
+	return row;
+}
+
+bool
+yuv_to_rgb48le_supported (AVPixelFormat format)
+{
+	switch (format) {
+	case AV_PIX_FMT_YUV420P:
+	case AV_PIX_FMT_YUV422P10LE:
+	case AV_PIX_FMT_YUV444P12LE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/** Convert part of a limited-range planar YUV image to RGB48LE; this assumes that
+ *  we are on a little-endian machine.
+ *  @param format Format of the YUV image; yuv_to_rgb48le_supported() must return true for it.
+ *  @param yuv_to_rgb YUV to RGB transformation to use.
+ *  @param data YUV image planes.
+ *  @param stride YUV image strides in bytes.
+ *  @param size YUV image size.
+ *  @param x First pixel of each row to convert.
+ *  @param y First row to convert.
+ *  @param out_size Size of the area to convert.
+ *  @param out First RGB48LE pixel to write to.
+ *  @param out_stride Stride of the RGB48LE image in bytes.
+ *  @param level Instruction set to use.
+ */
+void
+yuv_to_rgb48le (
+	AVPixelFormat format, dcp::YUVToRGB yuv_to_rgb,
+	uint8_t const * const * data, int const * stride, dcp::Size size,
+	int x, int y, dcp::Size out_size, uint8_t* out, int out_stride,
+	SIMDLevel level
+	)
+{
+	DCPOMATIC_ASSERT (x >= 0 && y >= 0 && (x + out_size.width) <= size.width && (y + out_size.height) <= size.height);
+
+	switch (format) {
+	case AV_PIX_FMT_YUV420P:
+	{
+		YUVToRGB48Coefficients const k (yuv_to_rgb, 8);
+		for (int i = 0; i < out_size.height; ++i) {
+			YUVRow<uint8_t> const row = yuv_row<uint8_t> (data, stride, size.height, 1, 1, x, y + i);
+			uint16_t* q = reinterpret_cast<uint16_t*> (out + i * out_stride);
+			DCPOMATIC_KERNEL_CALL (yuv8_to_rgb48le, level, (row, q, out_size.width, k));
+		}
+		break;
+	}
+	case AV_PIX_FMT_YUV422P10LE:
+	case AV_PIX_FMT_YUV444P12LE:
+	{
+		bool const yuv422 = format == AV_PIX_FMT_YUV422P10LE;
+		YUVToRGB48Coefficients const k (yuv_to_rgb, yuv422 ? 10 : 12);
+		for (int i = 0; i < out_size.height; ++i) {
+			YUVRow<uint16_t> const row = yuv_row<uint16_t> (data, stride, size.height, yuv422 ? 1 : 0, 0, x, y + i);
+			uint16_t* q = reinterpret_cast<uint16_t*> (out + i * out_stride);
+			DCPOMATIC_KERNEL_CALL (yuv16_to_rgb48le, level, (row, q, out_size.width, k));
+		}
+		break;
+	}
+	default:
+		DCPOMATIC_ASSERT (false);
+	}
+}
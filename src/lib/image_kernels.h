@@ -0,0 +1,49 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/** @file  src/lib/image_kernels.h
+ *  @brief Inner loops of some Image operations, with versions for different instruction sets.
+ */
+
+#ifndef DCPOMATIC_IMAGE_KERNELS_H
+#define DCPOMATIC_IMAGE_KERNELS_H
+
+#include "simd.h"
+#include <dcp/types.h>
+extern "C" {
+#include <libavutil/pixfmt.h>
+}
+#include <stdint.h>
+
+extern bool alpha_blend_row_supported (AVPixelFormat format);
+extern void alpha_blend_row (AVPixelFormat format, uint8_t* target, uint8_t const * overlay, int pixels, SIMDLevel level);
+extern void fade_row_8 (uint8_t* data, int samples, float f, SIMDLevel level);
+extern void fade_row_16le (uint16_t* data, int samples, float f, SIMDLevel level);
+extern void fade_row_16be (uint16_t* data, int samples, float f, SIMDLevel level);
+extern void xyz12le_to_rgb24_row (uint16_t const * xyz, uint8_t* rgb, int pixels, SIMDLevel level);
+extern bool yuv_to_rgb48le_supported (AVPixelFormat format);
+extern void yuv_to_rgb48le (
+	AVPixelFormat format, dcp::YUVToRGB yuv_to_rgb,
+	uint8_t const * const * data, int const * stride, dcp::Size size,
+	int x, int y, dcp::Size out_size, uint8_t* out, int out_stride,
+	SIMDLevel level
+	);
+
+#endif
@@ -34,6 +34,7 @@
 #include "player.h"
 #include "player_video.h"
 #include "encode_server_description.h"
+#include "image_buffer_pool.h"
 #include "compose.hpp"
 #include <libcxml/cxml.h>
 #include <boost/foreach.hpp>
@@ -69,6 +70,10 @@ J2KEncoder::~J2KEncoder ()
 {
 	try {
 		terminate_threads ();
+		/* If end() was not called (e.g. the encode was cancelled) we still want to
+		   give back the encode's idle image buffers.
+		*/
+		ImageBufferPool::instance()->clear ();
 	} catch (...) {
 		/* Destructors must not throw exceptions; anything bad
 		   happening now is too late to worry about anyway,
@@ -143,6 +148,17 @@ J2KEncoder::end ()
 			LOG_ERROR (N_("Local encode failed (%1)"), e.what ());
 		}
 	}
+
+	ImageBufferPool::Statistics const pool = ImageBufferPool::instance()->statistics ();
+	LOG_GENERAL (
+		N_("Image buffers: %1 allocated, %2 re-used, %3 freed; peak %4MB"),
+		pool.allocations, pool.reuses, pool.frees, pool.peak_bytes / (1024 * 1024)
+		);
+
+	/* Give back the memory that the encode was using for images, rather than keeping
+	   it for the rest of the life of the process.
+	*/
+	ImageBufferPool::instance()->clear ();
 }
 
 /** @return an estimate of the current number of frames we are encoding per second,
@@ -37,6 +37,7 @@ using boost::optional;
 using boost::dynamic_pointer_cast;
 
 MagickImageProxy::MagickImageProxy (boost::filesystem::path path)
+	: _decoding (false)
 {
 	/* Read the file into a Blob */
 
@@ -58,6 +59,7 @@ MagickImageProxy::MagickImageProxy (boost::filesystem::path path)
 }
 
 MagickImageProxy::MagickImageProxy (shared_ptr<cxml::Node>, shared_ptr<Socket> socket)
+	: _decoding (false)
 {
 	uint32_t const size = socket->read_uint32 ();
 	uint8_t* data = new uint8_t[size];
@@ -66,19 +68,14 @@ MagickImageProxy::MagickImageProxy (shared_ptr<cxml::Node>, shared_ptr<Socket> s
 	delete[] data;
 }
 
-shared_ptr<Image>
-MagickImageProxy::image (optional<dcp::NoteHandler>, optional<dcp::Size>) const
+/** Decode an image file; this uses no state of ours so it can be called from many threads at once */
+static shared_ptr<Image>
+decode (Magick::Blob const & blob)
 {
-	boost::mutex::scoped_lock lm (_mutex);
-
-	if (_image) {
-		return _image;
-	}
-
 	Magick::Image* magick_image = 0;
 	string error;
 	try {
-		magick_image = new Magick::Image (_blob);
+		magick_image = new Magick::Image (blob);
 	} catch (Magick::Exception& e) {
 		error = e.what ();
 	}
@@ -89,7 +86,7 @@ MagickImageProxy::image (optional<dcp::NoteHandler>, optional<dcp::Size>) const
 		   is allowed, but it seems to work.
 		*/
 		try {
-			magick_image = new Magick::Image (_blob, Magick::Geometry (0, 0), "TGA");
+			magick_image = new Magick::Image (blob, Magick::Geometry (0, 0), "TGA");
 		} catch (...) {
 
 		}
@@ -116,10 +113,10 @@ MagickImageProxy::image (optional<dcp::NoteHandler>, optional<dcp::Size>) const
 
 	dcp::Size size (magick_image->columns(), magick_image->rows());
 
-	_image.reset (new Image (AV_PIX_FMT_RGB24, size, true));
+	shared_ptr<Image> image (new Image (AV_PIX_FMT_RGB24, size, true));
 
-	/* Write line-by-line here as _image must be aligned, and write() cannot be told about strides */
-	uint8_t* p = _image->data()[0];
+	/* Write line-by-line here as image must be aligned, and write() cannot be told about strides */
+	uint8_t* p = image->data()[0];
 	for (int i = 0; i < size.height; ++i) {
 #ifdef DCPOMATIC_HAVE_MAGICKCORE_NAMESPACE
 		using namespace MagickCore;
@@ -128,11 +125,49 @@ MagickImageProxy::image (optional<dcp::NoteHandler>, optional<dcp::Size>) const
 		using namespace MagickLib;
 #endif
 		magick_image->write (0, i, size.width, 1, "RGB", CharPixel, p);
-		p += _image->stride()[0];
+		p += image->stride()[0];
 	}
 
 	delete magick_image;
 
+	return image;
+}
+
+shared_ptr<Image>
+MagickImageProxy::image (optional<dcp::NoteHandler>, optional<dcp::Size>) const
+{
+	{
+		boost::mutex::scoped_lock lm (_mutex);
+
+		/* If another thread is decoding this image wait for it rather than doing the same work again */
+		while (_decoding) {
+			_decoded.wait (lm);
+		}
+
+		if (_image) {
+			return _image;
+		}
+
+		_decoding = true;
+	}
+
+	/* Decode without holding our lock; decode() uses nothing that is shared with other proxies,
+	   so different images can be decoded at the same time by as many threads as want to.
+	*/
+	shared_ptr<Image> image;
+	try {
+		image = decode (_blob);
+	} catch (...) {
+		boost::mutex::scoped_lock lm (_mutex);
+		_decoding = false;
+		_decoded.notify_all ();
+		throw;
+	}
+
+	boost::mutex::scoped_lock lm (_mutex);
+	_image = image;
+	_decoding = false;
+	_decoded.notify_all ();
 	return _image;
 }
 
@@ -21,6 +21,7 @@
 #include "image_proxy.h"
 #include <Magick++.h>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
 #include <boost/filesystem.hpp>
 
 class MagickImageProxy : public ImageProxy
@@ -42,5 +43,10 @@ public:
 private:
 	Magick::Blob _blob;
 	mutable boost::shared_ptr<Image> _image;
+	/** mutex to protect _image and _decoding; it is not held while decoding */
 	mutable boost::mutex _mutex;
+	/** true if some thread is decoding _blob into _image */
+	mutable bool _decoding;
+	/** condition which is signalled when a decode finishes (successfully or not) */
+	mutable boost::condition _decoded;
 };
@@ -29,6 +29,7 @@
 #include "ratio.h"
 #include "log.h"
 #include "render_subtitles.h"
+#include "subtitle_prerenderer.h"
 #include "config.h"
 #include "content_video.h"
 #include "player_video.h"
@@ -578,7 +579,10 @@ Player::pass ()
 	return done;
 }
 
-optional<PositionImage>
+/** @return Images of the subtitles which should be burnt into the frame at `time', in the
+ *  order that they should be blended.
+ */
+list<PositionImage>
 Player::subtitles_for_frame (DCPTime time) const
 {
 	list<PositionImage> subtitles;
@@ -596,11 +600,7 @@ Player::subtitles_for_frame (DCPTime time) const
 		}
 	}
 
-	if (subtitles.empty ()) {
-		return optional<PositionImage> ();
-	}
-
-	return merge (subtitles);
+	return subtitles;
 }
 
 void
@@ -813,6 +813,23 @@ Player::subtitle_stop (weak_ptr<Piece> wp, ContentTime to)
 	if (piece->content->subtitle->use() && !_always_burn_subtitles && !piece->content->subtitle->burn()) {
 		Subtitle (from.first, DCPTimePeriod (from.second, dcp_to));
 	}
+
+	if (!from.first.text.empty() && piece->content->subtitle->use() && (_always_burn_subtitles || piece->content->subtitle->burn())) {
+		/* Start rendering these now so that they are (hopefully) ready by the time
+		   subtitles_for_frame() wants them.  This must wait until now as their out
+		   times (which affect how they are rendered) are not known until they stop.
+		   Render them as they will be on their first frame and, if they fade in, once
+		   they have finished fading in.
+		*/
+		if (!_subtitle_prerenderer) {
+			_subtitle_prerenderer.reset (new SubtitlePrerenderer ());
+		}
+		_subtitle_prerenderer->add (from.first.text, from.first.fonts, _video_container_size, from.second);
+		DCPTime const fade_up = DCPTime::from_seconds (from.first.text.front().fade_up_time().as_seconds ());
+		if (fade_up > DCPTime ()) {
+			_subtitle_prerenderer->add (from.first.text, from.first.fonts, _video_container_size, from.second + fade_up);
+		}
+	}
 }
 
 void
@@ -824,6 +841,9 @@ Player::seek (DCPTime time, bool accurate)
 
 	_audio_merger.clear ();
 	_active_subtitles.clear ();
+	if (_subtitle_prerenderer) {
+		_subtitle_prerenderer->clear ();
+	}
 
 	BOOST_FOREACH (shared_ptr<Piece> i, _pieces) {
 		if (time < i->content->position()) {
@@ -857,9 +877,9 @@ Player::seek (DCPTime time, bool accurate)
 void
 Player::emit_video (shared_ptr<PlayerVideo> pv, DCPTime time)
 {
-	optional<PositionImage> subtitles = subtitles_for_frame (time);
-	if (subtitles) {
-		pv->set_subtitle (subtitles.get ());
+	list<PositionImage> subtitles = subtitles_for_frame (time);
+	if (!subtitles.empty ()) {
+		pv->set_subtitles (subtitles);
 	}
 
 	Video (pv, time);
@@ -46,6 +46,7 @@ class Playlist;
 class Font;
 class AudioBuffers;
 class ReferencedReelAsset;
+class SubtitlePrerenderer;
 
 /** @class Player
  *  @brief A class which can `play' a Playlist.
@@ -114,7 +115,7 @@ private:
 	std::pair<boost::shared_ptr<AudioBuffers>, DCPTime> discard_audio (
 		boost::shared_ptr<const AudioBuffers> audio, DCPTime time, DCPTime discard_to
 		) const;
-	boost::optional<PositionImage> subtitles_for_frame (DCPTime time) const;
+	std::list<PositionImage> subtitles_for_frame (DCPTime time) const;
 	void emit_video (boost::shared_ptr<PlayerVideo> pv, DCPTime time);
 	void emit_audio (boost::shared_ptr<AudioBuffers> data, DCPTime time);
 
@@ -171,6 +172,10 @@ private:
 	Empty _silent;
 
 	ActiveSubtitles _active_subtitles;
+	/** Thread to render text subtitles that will be burnt in before they are needed;
+	 *  made when the first such subtitle arrives.
+	 */
+	boost::shared_ptr<SubtitlePrerenderer> _subtitle_prerenderer;
 	boost::shared_ptr<AudioProcessor> _audio_processor;
 
 	boost::signals2::scoped_connection _film_changed_connection;
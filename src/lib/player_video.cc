@@ -23,15 +23,21 @@
 #include "image_proxy.h"
 #include "j2k_image_proxy.h"
 #include "film.h"
+#include "fused_xyz.h"
 #include <dcp/raw_convert.h>
+#include <dcp/rgb_xyz.h>
+#include <dcp/openjpeg_image.h>
 extern "C" {
 #include <libavutil/pixfmt.h>
 }
 #include <libxml++/libxml++.h>
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
 #include <iostream>
 
 using std::string;
 using std::cout;
+using std::list;
 using boost::shared_ptr;
 using boost::dynamic_pointer_cast;
 using boost::optional;
@@ -76,22 +82,26 @@ PlayerVideo::PlayerVideo (shared_ptr<cxml::Node> node, shared_ptr<Socket> socket
 
 	_in = image_proxy_factory (node->node_child ("In"), socket);
 
-	if (node->optional_number_child<int> ("SubtitleX")) {
+	BOOST_FOREACH (cxml::NodePtr i, node->node_children ("Subtitle")) {
 
 		shared_ptr<Image> image (
-			new Image (AV_PIX_FMT_RGBA, dcp::Size (node->number_child<int> ("SubtitleWidth"), node->number_child<int> ("SubtitleHeight")), true)
+			new Image (AV_PIX_FMT_RGBA, dcp::Size (i->number_child<int> ("Width"), i->number_child<int> ("Height")), true)
 			);
 
 		image->read_from_socket (socket);
 
-		_subtitle = PositionImage (image, Position<int> (node->number_child<int> ("SubtitleX"), node->number_child<int> ("SubtitleY")));
+		_subtitles.push_back (PositionImage (image, Position<int> (i->number_child<int> ("X"), i->number_child<int> ("Y"))));
 	}
 }
 
+/** Set the subtitle images that will be blended onto this frame, replacing any that were set before.
+ *  They are blended separately (in order) rather than being merged into one image first,
+ *  which saves making a large, mostly transparent image when they are far apart.
+ */
 void
-PlayerVideo::set_subtitle (PositionImage image)
+PlayerVideo::set_subtitles (list<PositionImage> subtitles)
 {
-	_subtitle = image;
+	_subtitles = subtitles;
 }
 
 /** Create an image for this frame.
@@ -104,6 +114,51 @@ PlayerVideo::set_subtitle (PositionImage image)
  */
 shared_ptr<Image>
 PlayerVideo::image (dcp::NoteHandler note, function<AVPixelFormat (AVPixelFormat)> pixel_format, bool aligned, bool fast) const
+{
+	shared_ptr<Image> out = scaled_image (note, pixel_format, aligned, fast);
+
+	BOOST_FOREACH (PositionImage const & i, _subtitles) {
+		out->alpha_blend (Image::ensure_aligned (i.image), i.position);
+	}
+
+	if (_fade) {
+		out->fade (_fade.get ());
+	}
+
+	return out;
+}
+
+/** Create an XYZ image for this frame, ready for JPEG2000 encoding.  This
+ *  must only be called if we have a colour conversion.
+ *  @param note Handler for any notes that are made during the process.
+ */
+shared_ptr<dcp::OpenJPEGImage>
+PlayerVideo::xyz_image (dcp::NoteHandler note) const
+{
+	DCPOMATIC_ASSERT (_colour_conversion);
+
+	shared_ptr<Image> image = scaled_image (note, bind (&PlayerVideo::keep_xyz_or_rgb, _1), true, false);
+	if (image->pixel_format() == AV_PIX_FMT_RGB48LE) {
+		/* Do the subtitle, fade and colour conversion in one go */
+		return fused_rgb_to_xyz (image, _subtitles, _fade, _colour_conversion.get(), note);
+	}
+
+	BOOST_FOREACH (PositionImage const & i, _subtitles) {
+		image->alpha_blend (Image::ensure_aligned (i.image), i.position);
+	}
+
+	if (_fade) {
+		image->fade (_fade.get ());
+	}
+
+	return dcp::rgb_to_xyz (image->data()[0], image->size(), image->stride()[0], _colour_conversion.get(), note);
+}
+
+/** Crop and scale our input image, without adding subtitles or fading.
+ *  Parameters are as for image().
+ */
+shared_ptr<Image>
+PlayerVideo::scaled_image (dcp::NoteHandler note, function<AVPixelFormat (AVPixelFormat)> pixel_format, bool aligned, bool fast) const
 {
 	shared_ptr<Image> im = _in->image (optional<dcp::NoteHandler> (note), _inter_size);
 
@@ -130,19 +185,9 @@ PlayerVideo::image (dcp::NoteHandler note, function<AVPixelFormat (AVPixelFormat
 		yuv_to_rgb = _colour_conversion.get().yuv_to_rgb();
 	}
 
-	shared_ptr<Image> out = im->crop_scale_window (
+	return im->crop_scale_window (
 		total_crop, _inter_size, _out_size, yuv_to_rgb, pixel_format (_in->pixel_format()), aligned, fast
 		);
-
-	if (_subtitle) {
-		out->alpha_blend (Image::ensure_aligned (_subtitle->image), _subtitle->position);
-	}
-
-	if (_fade) {
-		out->fade (_fade.get ());
-	}
-
-	return out;
 }
 
 void
@@ -162,11 +207,12 @@ PlayerVideo::add_metadata (xmlpp::Node* node) const
 	if (_colour_conversion) {
 		_colour_conversion.get().as_xml (node);
 	}
-	if (_subtitle) {
-		node->add_child ("SubtitleWidth")->add_child_text (raw_convert<string> (_subtitle->image->size().width));
-		node->add_child ("SubtitleHeight")->add_child_text (raw_convert<string> (_subtitle->image->size().height));
-		node->add_child ("SubtitleX")->add_child_text (raw_convert<string> (_subtitle->position.x));
-		node->add_child ("SubtitleY")->add_child_text (raw_convert<string> (_subtitle->position.y));
+	BOOST_FOREACH (PositionImage const & i, _subtitles) {
+		xmlpp::Node* sub = node->add_child ("Subtitle");
+		sub->add_child("Width")->add_child_text (raw_convert<string> (i.image->size().width));
+		sub->add_child("Height")->add_child_text (raw_convert<string> (i.image->size().height));
+		sub->add_child("X")->add_child_text (raw_convert<string> (i.position.x));
+		sub->add_child("Y")->add_child_text (raw_convert<string> (i.position.y));
 	}
 }
 
@@ -174,8 +220,8 @@ void
 PlayerVideo::send_binary (shared_ptr<Socket> socket) const
 {
 	_in->send_binary (socket);
-	if (_subtitle) {
-		_subtitle->image->write_to_socket (socket);
+	BOOST_FOREACH (PositionImage const & i, _subtitles) {
+		i.image->write_to_socket (socket);
 	}
 }
 
@@ -189,7 +235,7 @@ PlayerVideo::has_j2k () const
 		return false;
 	}
 
-	return _crop == Crop () && _out_size == j2k->size() && !_subtitle && !_fade && !_colour_conversion;
+	return _crop == Crop () && _out_size == j2k->size() && _subtitles.empty() && !_fade && !_colour_conversion;
 }
 
 Data
@@ -220,17 +266,21 @@ PlayerVideo::same (shared_ptr<const PlayerVideo> other) const
 		return false;
 	}
 
-	if ((!_subtitle && other->_subtitle) || (_subtitle && !other->_subtitle)) {
-		/* One has a subtitle and the other doesn't */
+	if (_subtitles.size() != other->_subtitles.size()) {
+		/* They have different numbers of subtitles */
 		return false;
 	}
 
-	if (_subtitle && other->_subtitle && !_subtitle->same (other->_subtitle.get ())) {
-		/* They both have subtitles but they are different */
-		return false;
+	list<PositionImage>::const_iterator j = other->_subtitles.begin ();
+	BOOST_FOREACH (PositionImage const & i, _subtitles) {
+		if (!i.same (*j)) {
+			/* They both have subtitles but they are different */
+			return false;
+		}
+		++j;
 	}
 
-	/* Now neither has subtitles */
+	/* Now the subtitles are the same */
 
 	return _in->same (other->_in);
 }
@@ -30,11 +30,16 @@ extern "C" {
 #include <libavutil/pixfmt.h>
 }
 #include <boost/shared_ptr.hpp>
+#include <list>
 
 class Image;
 class ImageProxy;
 class Socket;
 
+namespace dcp {
+	class OpenJPEGImage;
+}
+
 /** Everything needed to describe a video frame coming out of the player, but with the
  *  bits still their raw form.  We may want to combine the bits on a remote machine,
  *  or maybe not even bother to combine them at all.
@@ -55,9 +60,10 @@ public:
 
 	PlayerVideo (boost::shared_ptr<cxml::Node>, boost::shared_ptr<Socket>);
 
-	void set_subtitle (PositionImage);
+	void set_subtitles (std::list<PositionImage> subtitles);
 
 	boost::shared_ptr<Image> image (dcp::NoteHandler note, boost::function<AVPixelFormat (AVPixelFormat)> pixel_format, bool aligned, bool fast) const;
+	boost::shared_ptr<dcp::OpenJPEGImage> xyz_image (dcp::NoteHandler note) const;
 
 	static AVPixelFormat always_rgb (AVPixelFormat);
 	static AVPixelFormat keep_xyz_or_rgb (AVPixelFormat);
@@ -91,6 +97,8 @@ public:
 	bool same (boost::shared_ptr<const PlayerVideo> other) const;
 
 private:
+	boost::shared_ptr<Image> scaled_image (dcp::NoteHandler note, boost::function<AVPixelFormat (AVPixelFormat)> pixel_format, bool aligned, bool fast) const;
+
 	boost::shared_ptr<const ImageProxy> _in;
 	Crop _crop;
 	boost::optional<double> _fade;
@@ -99,7 +107,8 @@ private:
 	Eyes _eyes;
 	Part _part;
 	boost::optional<ColourConversion> _colour_conversion;
-	boost::optional<PositionImage> _subtitle;
+	/** Subtitle images to blend onto the frame, in order */
+	std::list<PositionImage> _subtitles;
 };
 
 #endif
@@ -27,6 +27,8 @@
 #include "font.h"
 #include "compose.hpp"
 #include "audio_buffers.h"
+#include "audio_accumulator.h"
+#include "config.h"
 #include <dcp/mono_picture_asset.h>
 #include <dcp/stereo_picture_asset.h>
 #include <dcp/sound_asset.h>
@@ -54,13 +56,26 @@
 using std::list;
 using std::string;
 using std::cout;
+using std::max;
 using boost::shared_ptr;
 using boost::optional;
 using boost::dynamic_pointer_cast;
 using dcp::Data;
 using dcp::raw_convert;
 
+/** Give back the unused part of the disk space reserved for a file, then delete our note of its path */
+static void
+release_and_delete (boost::filesystem::path* path)
+{
+	release_preallocation (*path);
+	delete path;
+}
+
 int const ReelWriter::_info_size = 48;
+/** size of each entry in the journal file: a frame index and its hash */
+int const ReelWriter::_journal_size = 40;
+/** number of frames between journal entries */
+int const ReelWriter::_journal_interval = 256;
 
 ReelWriter::ReelWriter (
 	shared_ptr<const Film> film, DCPTimePeriod period, shared_ptr<Job> job, int reel_index, int reel_count, optional<string> content_summary
@@ -74,6 +89,8 @@ ReelWriter::ReelWriter (
 	, _reel_index (reel_index)
 	, _reel_count (reel_count)
 	, _content_summary (content_summary)
+	, _picture_size (0)
+	, _picture_space_reserved (false)
 {
 	/* Create our picture asset in a subdirectory, named according to those
 	   film's parameters which affect the video output.  We will hard-link
@@ -100,6 +117,29 @@ ReelWriter::ReelWriter (
 	job->sub (_("Checking existing image data"));
 	check_existing_picture_asset ();
 
+	if (_first_nonexistant_frame == 0) {
+		/* We are starting from scratch so anything in the journal is out of date */
+		boost::system::error_code ec;
+		boost::filesystem::remove (_film->journal_file (_period), ec);
+	}
+
+	/* Check now, rather than hours into the encode, that there is room for the
+	   rest of the picture asset.
+	*/
+	_picture_size = int64_t (_film->j2k_bandwidth() / 8) * _period.duration().seconds();
+	boost::uintmax_t existing = 0;
+	boost::system::error_code ec;
+	if (_first_nonexistant_frame > 0) {
+		existing = boost::filesystem::file_size (_picture_asset->file().get(), ec);
+		if (ec) {
+			existing = 0;
+		}
+	}
+	boost::filesystem::space_info const space = boost::filesystem::space (_film->internal_video_asset_dir(), ec);
+	if (!ec && boost::uintmax_t (_picture_size) > existing && space.available < boost::uintmax_t (_picture_size) - existing) {
+		throw_not_enough_space ();
+	}
+
 	_picture_asset_writer = _picture_asset->start_write (
 		_film->internal_video_asset_dir() / _film->internal_video_asset_filename(_period),
 		_film->interop() ? dcp::INTEROP : dcp::SMPTE,
@@ -124,6 +164,8 @@ ReelWriter::ReelWriter (
 			_film->directory().get() / audio_asset_filename (_sound_asset, _reel_index, _reel_count, _content_summary),
 			_film->interop() ? dcp::INTEROP : dcp::SMPTE
 			);
+
+		_audio_accumulator.reset (new AudioAccumulator (_film->audio_channels(), Config::instance()->sound_write_block()));
 	}
 }
 
@@ -195,6 +237,69 @@ ReelWriter::frame_info_position (Frame frame, Eyes eyes) const
 	DCPOMATIC_ASSERT (false);
 }
 
+/** Write an entry to the journal if this frame is one that we record there.
+ *  @param frame reel-relative frame.
+ */
+void
+ReelWriter::write_journal (Frame frame, Eyes eyes, dcp::FrameInfo info) const
+{
+	/* For 3D we record left-eye frames, as those are the ones that
+	   check_existing_picture_asset() looks at.
+	*/
+	if (eyes == EYES_RIGHT || ((frame + 1) % _journal_interval) != 0) {
+		return;
+	}
+
+	boost::filesystem::path const journal = _film->journal_file (_period);
+	FILE* file = fopen_boost (journal, "ab");
+	if (!file) {
+		throw OpenFileError (journal, errno, false);
+	}
+	int64_t const f = frame;
+	fwrite (&f, sizeof (f), 1, file);
+	fwrite (info.hash.c_str(), 1, 32, file);
+	fclose (file);
+}
+
+/** Look at the last entry in the journal and check that the frame it
+ *  describes is still present and correct in our asset.
+ *  @return Index of that frame, if it is good.
+ */
+optional<Frame>
+ReelWriter::read_journal (FILE* asset_file, FILE* info_file) const
+{
+	boost::filesystem::path const journal = _film->journal_file (_period);
+	boost::system::error_code ec;
+	uintmax_t const size = boost::filesystem::file_size (journal, ec);
+	if (ec || size < static_cast<uintmax_t> (_journal_size)) {
+		return optional<Frame> ();
+	}
+
+	FILE* file = fopen_boost (journal, "rb");
+	if (!file) {
+		return optional<Frame> ();
+	}
+
+	dcpomatic_fseek (file, (size / _journal_size - 1) * _journal_size, SEEK_SET);
+	int64_t frame = 0;
+	fread (&frame, sizeof (frame), 1, file);
+	char hash_buffer[33];
+	fread (hash_buffer, 1, 32, file);
+	hash_buffer[32] = '\0';
+	fclose (file);
+
+	LOG_GENERAL ("Journal says frame %1 was written", frame);
+
+	/* The journal entry must agree with the info file, and the frame must agree with both */
+	dcp::FrameInfo const info = read_frame_info (info_file, frame, _film->three_d() ? EYES_LEFT : EYES_BOTH);
+	if (info.hash != hash_buffer || !existing_picture_frame_ok (asset_file, info_file, frame)) {
+		LOG_GENERAL ("Journal entry for frame %1 does not match the asset", frame);
+		return optional<Frame> ();
+	}
+
+	return frame;
+}
+
 void
 ReelWriter::check_existing_picture_asset ()
 {
@@ -219,22 +324,55 @@ ReelWriter::check_existing_picture_asset ()
 		return;
 	}
 
-	if (_film->three_d ()) {
-		/* Start looking at the last left frame */
-		_first_nonexistant_frame = n / 2;
-	} else {
-		_first_nonexistant_frame = n;
+	/* Last frame that the info file knows about; for 3D we look at left frames */
+	Frame const last = n < 0 ? -1 : (_film->three_d() ? n / 2 : n);
+
+	/* Start from the journal's last good frame if we can; otherwise from nothing */
+	Frame good = -1;
+	optional<Frame> const journal = read_journal (asset_file, info_file);
+	if (journal && journal.get() <= last) {
+		good = journal.get ();
 	}
 
-	while (!existing_picture_frame_ok(asset_file, info_file) && _first_nonexistant_frame > 0) {
-		--_first_nonexistant_frame;
+	/* Frames are written in order, so the good ones are all before the bad ones
+	   and we can binary-search for the last good one.  Then check a few frames
+	   before it in case something else has gone wrong, and search again below
+	   any that fail.
+	*/
+	Frame bad = last + 1;
+	while (true) {
+		while (bad - good > 1) {
+			Frame const mid = good + (bad - good) / 2;
+			if (existing_picture_frame_ok (asset_file, info_file, mid)) {
+				good = mid;
+			} else {
+				bad = mid;
+			}
+		}
+
+		int const samples = 4;
+		optional<Frame> failed;
+		for (int i = 1; i <= samples && (good - i) >= 0; ++i) {
+			Frame const f = good - i;
+			if (!existing_picture_frame_ok (asset_file, info_file, f)) {
+				failed = f;
+				break;
+			}
+		}
+
+		if (!failed) {
+			break;
+		}
+
+		good = -1;
+		bad = failed.get ();
 	}
 
-	if (!_film->three_d() && _first_nonexistant_frame > 0) {
-		/* If we are doing 3D we might have found a good L frame with no R, so only
-		   do this if we're in 2D and we've just found a good B(oth) frame.
-		*/
-		++_first_nonexistant_frame;
+	if (_film->three_d ()) {
+		/* We might have found a good L frame with no R, so start again at that L */
+		_first_nonexistant_frame = max (good, Frame (0));
+	} else {
+		_first_nonexistant_frame = good + 1;
 	}
 
 	LOG_GENERAL ("Proceeding with first nonexistant frame %1", _first_nonexistant_frame);
@@ -243,11 +381,50 @@ ReelWriter::check_existing_picture_asset ()
 	fclose (info_file);
 }
 
+void
+ReelWriter::throw_not_enough_space () const
+{
+	throw FileError (
+		String::compose (
+			_("There is not enough disk space to write the picture data for reel %1; about %2Gb is needed."),
+			_reel_index + 1, (_picture_size + 1073741823) / 1073741824
+			),
+		_picture_asset->file().get()
+		);
+}
+
+/** Reserve the space that we expect the picture asset to take up, both to avoid it
+ *  being fragmented over the disk and so that we find out early if the space runs out.
+ *  This must be called once the asset's file exists; libdcp only creates it on the
+ *  first write, and creating it ourselves is no good as a new asset is opened with
+ *  truncation, which would give the reservation straight back.
+ */
+void
+ReelWriter::reserve_picture_space ()
+{
+	_picture_space_reserved = true;
+
+	int const e = preallocate_file (_picture_asset->file().get(), _picture_size);
+	if (e == 0) {
+		_picture_preallocation.reset (new boost::filesystem::path (_picture_asset->file().get()), &release_and_delete);
+	} else if (e == ENOSPC) {
+		/* Some of the space may have been reserved before we ran out */
+		release_preallocation (_picture_asset->file().get());
+		throw_not_enough_space ();
+	} else {
+		LOG_GENERAL ("Could not preallocate %1 bytes for %2 (errno=%3)", _picture_size, _picture_asset->file()->string(), e);
+	}
+}
+
 void
 ReelWriter::write (optional<Data> encoded, Frame frame, Eyes eyes)
 {
 	dcp::FrameInfo fin = _picture_asset_writer->write (encoded->data().get (), encoded->size());
+	if (!_picture_space_reserved) {
+		reserve_picture_space ();
+	}
 	write_frame_info (frame, eyes, fin);
+	write_journal (frame, eyes, fin);
 	_last_written[eyes] = encoded;
 	_last_written_video_frame = frame;
 	_last_written_eyes = eyes;
@@ -257,6 +434,9 @@ void
 ReelWriter::fake_write (Frame frame, Eyes eyes, int size)
 {
 	_picture_asset_writer->fake_write (size);
+	if (!_picture_space_reserved) {
+		reserve_picture_space ();
+	}
 	_last_written_video_frame = frame;
 	_last_written_eyes = eyes;
 }
@@ -268,20 +448,37 @@ ReelWriter::repeat_write (Frame frame, Eyes eyes)
 		_last_written[eyes]->data().get(),
 		_last_written[eyes]->size()
 		);
+	if (!_picture_space_reserved) {
+		reserve_picture_space ();
+	}
 	write_frame_info (frame, eyes, fin);
+	write_journal (frame, eyes, fin);
 	_last_written_video_frame = frame;
 	_last_written_eyes = eyes;
 }
 
+/** @param set_progress Function to report progress of any copying that has to be done */
 void
-ReelWriter::finish ()
+ReelWriter::finish (boost::function<void (float)> set_progress)
 {
-	if (!_picture_asset_writer->finalize ()) {
+	bool const picture_written = _picture_asset_writer->finalize ();
+
+	/* Give back any space that we reserved but did not use */
+	_picture_preallocation.reset ();
+
+	if (!picture_written) {
 		/* Nothing was written to the picture asset */
 		LOG_GENERAL ("Nothing was written to reel %1 of %2", _reel_index, _reel_count);
 		_picture_asset.reset ();
 	}
 
+	if (_sound_asset_writer) {
+		shared_ptr<const AudioBuffers> rest = _audio_accumulator->flush ();
+		if (rest) {
+			_sound_asset_writer->write (rest->data(), rest->frames());
+		}
+	}
+
 	if (_sound_asset_writer && !_sound_asset_writer->finalize ()) {
 		/* Nothing was written to the sound asset */
 		_sound_asset.reset ();
@@ -299,10 +496,11 @@ ReelWriter::finish ()
 		boost::filesystem::create_hard_link (video_from, video_to, ec);
 		if (ec) {
 			LOG_WARNING_NC ("Hard-link failed; copying instead");
-			boost::filesystem::copy_file (video_from, video_to, ec);
-			if (ec) {
-				LOG_ERROR ("Failed to copy video file from %1 to %2 (%3)", video_from.string(), video_to.string(), ec.message ());
-				throw FileError (ec.message(), video_from);
+			try {
+				copy_file_fast (video_from, video_to, set_progress);
+			} catch (FileError& e) {
+				LOG_ERROR ("Failed to copy video file from %1 to %2 (%3)", video_from.string(), video_to.string(), e.what ());
+				throw;
 			}
 		}
 
@@ -505,7 +703,9 @@ ReelWriter::write (shared_ptr<const AudioBuffers> audio)
 	}
 
 	if (audio) {
-		_sound_asset_writer->write (audio->data(), audio->frames());
+		BOOST_FOREACH (shared_ptr<const AudioBuffers> i, _audio_accumulator->push (audio)) {
+			_sound_asset_writer->write (i->data(), i->frames());
+		}
 	}
 
 	_total_written_audio_frames += audio->frames ();
@@ -547,15 +747,14 @@ ReelWriter::write (PlayerSubtitles subs)
 	}
 }
 
+/** @param frame reel-relative frame to check */
 bool
-ReelWriter::existing_picture_frame_ok (FILE* asset_file, FILE* info_file) const
+ReelWriter::existing_picture_frame_ok (FILE* asset_file, FILE* info_file, Frame frame) const
 {
-	LOG_GENERAL ("Checking existing picture frame %1", _first_nonexistant_frame);
+	LOG_GENERAL ("Checking existing picture frame %1", frame);
 
-	/* Read the data from the info file; for 3D we just check the left
-	   frames until we find a good one.
-	*/
-	dcp::FrameInfo const info = read_frame_info (info_file, _first_nonexistant_frame, _film->three_d () ? EYES_LEFT : EYES_BOTH);
+	/* Read the data from the info file; for 3D we just check the left frame */
+	dcp::FrameInfo const info = read_frame_info (info_file, frame, _film->three_d () ? EYES_LEFT : EYES_BOTH);
 
 	bool ok = true;
 
@@ -565,14 +764,14 @@ ReelWriter::existing_picture_frame_ok (FILE* asset_file, FILE* info_file) const
 	size_t const read = fread (data.data().get(), 1, data.size(), asset_file);
 	LOG_GENERAL ("Read %1 bytes of asset data; wanted %2", read, info.size);
 	if (read != static_cast<size_t> (data.size ())) {
-		LOG_GENERAL ("Existing frame %1 is incomplete", _first_nonexistant_frame);
+		LOG_GENERAL ("Existing frame %1 is incomplete", frame);
 		ok = false;
 	} else {
 		Digester digester;
 		digester.add (data.data().get(), data.size());
 		LOG_GENERAL ("Hash %1 vs %2", digester.get(), info.hash);
 		if (digester.get() != info.hash) {
-			LOG_GENERAL ("Existing frame %1 failed hash check", _first_nonexistant_frame);
+			LOG_GENERAL ("Existing frame %1 failed hash check", frame);
 			ok = false;
 		}
 	}
@@ -24,11 +24,13 @@
 #include "player_subtitles.h"
 #include <dcp/picture_asset_writer.h>
 #include <boost/shared_ptr.hpp>
+#include <boost/filesystem.hpp>
 
 class Film;
 class Job;
 class Font;
 class AudioBuffers;
+class AudioAccumulator;
 
 namespace dcp {
 	class MonoPictureAsset;
@@ -62,7 +64,7 @@ public:
 	void write (boost::shared_ptr<const AudioBuffers> audio);
 	void write (PlayerSubtitles subs);
 
-	void finish ();
+	void finish (boost::function<void (float)> set_progress);
 	boost::shared_ptr<dcp::Reel> create_reel (std::list<ReferencedReelAsset> const & refs, std::list<boost::shared_ptr<Font> > const & fonts);
 	void calculate_digests (boost::function<void (float)> set_progress);
 
@@ -94,8 +96,12 @@ private:
 
 	void write_frame_info (Frame frame, Eyes eyes, dcp::FrameInfo info) const;
 	long frame_info_position (Frame frame, Eyes eyes) const;
+	void write_journal (Frame frame, Eyes eyes, dcp::FrameInfo info) const;
+	boost::optional<Frame> read_journal (FILE* asset_file, FILE* info_file) const;
 	void check_existing_picture_asset ();
-	bool existing_picture_frame_ok (FILE* asset_file, FILE* info_file) const;
+	bool existing_picture_frame_ok (FILE* asset_file, FILE* info_file, Frame frame) const;
+	void reserve_picture_space ();
+	void throw_not_enough_space () const;
 
 	boost::shared_ptr<const Film> _film;
 
@@ -119,7 +125,20 @@ private:
 	boost::shared_ptr<dcp::PictureAssetWriter> _picture_asset_writer;
 	boost::shared_ptr<dcp::SoundAsset> _sound_asset;
 	boost::shared_ptr<dcp::SoundAssetWriter> _sound_asset_writer;
+	/** collects audio into larger blocks before it goes to _sound_asset_writer */
+	boost::shared_ptr<AudioAccumulator> _audio_accumulator;
 	boost::shared_ptr<dcp::SubtitleAsset> _subtitle_asset;
+	/** path of our picture asset if we have reserved disk space for it; the reservation
+	 *  is given back when finish() is called or when the last copy of this ReelWriter
+	 *  goes away (e.g. if the encode is cancelled or fails).
+	 */
+	boost::shared_ptr<boost::filesystem::path> _picture_preallocation;
+	/** the number of bytes that we expect the picture asset to take up */
+	int64_t _picture_size;
+	/** true if we have tried to reserve disk space for the picture asset */
+	bool _picture_space_reserved;
 
 	static int const _info_size;
+	static int const _journal_size;
+	static int const _journal_interval;
 };
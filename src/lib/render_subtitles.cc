@@ -32,21 +32,25 @@
 #include <pango/pangocairo.h>
 #endif
 #include <boost/foreach.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
 #include <iostream>
 
 using std::list;
+using std::map;
 using std::cout;
 using std::string;
 using std::min;
 using std::max;
-using std::pair;
 using std::cerr;
-using std::make_pair;
 using boost::shared_ptr;
 using boost::optional;
 
+/** Mutex to protect fc_config and fc_config_fonts, and fontconfig's current configuration */
+static boost::mutex fc_mutex;
 static FcConfig* fc_config = 0;
-static list<pair<FontFiles, string> > fc_config_fonts;
+/** Family names of the fonts that we have added to fc_config */
+static map<FontFiles, string> fc_config_fonts;
 
 string
 marked_up (list<SubtitleString> subtitles, int target_height, float fade_factor)
@@ -81,11 +85,148 @@ set_source_rgba (Cairo::RefPtr<Cairo::Context> context, dcp::Colour colour, floa
 	context->set_source_rgba (float(colour.r) / 255, float(colour.g) / 255, float(colour.b) / 255, fade_factor);
 }
 
+/** @return the font files to use when content does not specify any; these are
+ *  found the first time that we are called.
+ */
+static FontFiles
+default_font_files ()
+{
+	static boost::mutex mutex;
+	static optional<FontFiles> cached;
+
+	boost::mutex::scoped_lock lm (mutex);
+	if (cached) {
+		return *cached;
+	}
+
+	FontFiles font_files;
+
+	try {
+		font_files.set (FontFiles::NORMAL, shared_path () / "LiberationSans-Regular.ttf");
+		font_files.set (FontFiles::ITALIC, shared_path () / "LiberationSans-Italic.ttf");
+		font_files.set (FontFiles::BOLD, shared_path () / "LiberationSans-Bold.ttf");
+	} catch (boost::filesystem::filesystem_error& e) {
+
+	}
+
+	/* Hack: try the debian/ubuntu locations if getting the shared path failed */
+
+	if (!font_files.get(FontFiles::NORMAL) || !boost::filesystem::exists(font_files.get(FontFiles::NORMAL).get())) {
+		font_files.set (FontFiles::NORMAL, "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf");
+	}
+	if (!font_files.get(FontFiles::ITALIC) || !boost::filesystem::exists(font_files.get(FontFiles::ITALIC).get())) {
+		font_files.set (FontFiles::ITALIC, "/usr/share/fonts/truetype/liberation/LiberationSans-Italic.ttf");
+	}
+	if (!font_files.get(FontFiles::BOLD) || !boost::filesystem::exists(font_files.get(FontFiles::BOLD).get())) {
+		font_files.set (FontFiles::BOLD, "/usr/share/fonts/truetype/liberation/LiberationSans-Bold.ttf");
+	}
+
+	cached = font_files;
+	return font_files;
+}
+
+/** @return the font files to use for a line whose first subtitle is `first' */
+static FontFiles
+font_files_for (SubtitleString const & first, list<shared_ptr<Font> > fonts)
+{
+	optional<FontFiles> font_files;
+	BOOST_FOREACH (shared_ptr<Font> i, fonts) {
+		if (i->id() == first.font() && i->file(FontFiles::NORMAL)) {
+			font_files = i->files ();
+		}
+	}
+
+	return font_files ? *font_files : default_font_files ();
+}
+
+/** @return the fade factor (from 0 to 1) for a line whose first subtitle is `first' at a given time */
+static float
+fade_factor_for (SubtitleString const & first, DCPTime time)
+{
+	float fade_factor = 1;
+
+	DCPTime const fade_in_start = DCPTime::from_seconds (first.in().as_seconds ());
+	DCPTime const fade_in_end = fade_in_start + DCPTime::from_seconds (first.fade_up_time().as_seconds ());
+	DCPTime const fade_out_end =  DCPTime::from_seconds (first.out().as_seconds ());
+	DCPTime const fade_out_start = fade_out_end - DCPTime::from_seconds (first.fade_down_time().as_seconds ());
+	if (fade_in_start <= time && time <= fade_in_end && fade_in_start != fade_in_end) {
+		fade_factor = DCPTime(time - fade_in_start).seconds() / DCPTime(fade_in_end - fade_in_start).seconds();
+	} else if (fade_out_start <= time && time <= fade_out_end && fade_out_start != fade_out_end) {
+		fade_factor = 1 - DCPTime(time - fade_out_start).seconds() / DCPTime(fade_out_end - fade_out_start).seconds();
+	} else if (time < fade_in_start || time > fade_out_end) {
+		fade_factor = 0;
+	}
+
+	return fade_factor;
+}
+
+/** @return the family name of a font, making it available to fontconfig if it is not already.
+ *  The caller must hold fc_mutex.
+ */
+static string
+font_name_for (FontFiles const & font_files)
+{
+	if (!fc_config) {
+		fc_config = FcConfigCreate ();
+	}
+
+	map<FontFiles, string>::const_iterator existing = fc_config_fonts.find (font_files);
+	if (existing != fc_config_fonts.end ()) {
+		return existing->second;
+	}
+
+	string font_name;
+
+	/* Make this font available to DCP-o-matic */
+	for (int i = 0; i < FontFiles::VARIANTS; ++i) {
+		if (font_files.get(static_cast<FontFiles::Variant>(i))) {
+			FcConfigAppFontAddFile (
+				fc_config,
+				reinterpret_cast<FcChar8 const *> (font_files.get(static_cast<FontFiles::Variant>(i)).get().string().c_str())
+				);
+		}
+	}
+
+	FcPattern* pattern = FcPatternBuild (
+		0, FC_FILE, FcTypeString, font_files.get(FontFiles::NORMAL).get().string().c_str(), static_cast<char *> (0)
+		);
+	FcObjectSet* object_set = FcObjectSetBuild (FC_FAMILY, FC_STYLE, FC_LANG, FC_FILE, static_cast<char *> (0));
+	FcFontSet* font_set = FcFontList (fc_config, pattern, object_set);
+	if (font_set) {
+		for (int i = 0; i < font_set->nfont; ++i) {
+			FcPattern* font = font_set->fonts[i];
+			FcChar8* file;
+			FcChar8* family;
+			FcChar8* style;
+			if (
+				FcPatternGetString (font, FC_FILE, 0, &file) == FcResultMatch &&
+				FcPatternGetString (font, FC_FAMILY, 0, &family) == FcResultMatch &&
+				FcPatternGetString (font, FC_STYLE, 0, &style) == FcResultMatch
+				) {
+				font_name = reinterpret_cast<char const *> (family);
+			}
+		}
+
+		FcFontSetDestroy (font_set);
+	}
+
+	FcObjectSetDestroy (object_set);
+	FcPatternDestroy (pattern);
+
+	fc_config_fonts[font_files] = font_name;
+
+	return font_name;
+}
+
 /** @param subtitles A list of subtitles that are all on the same line,
  *  at the same time and with the same fade in/out.
+ *  @param font_files Font to use, from font_files_for().
+ *  @param fade_factor Fade to apply, from fade_factor_for().
+ *  @param full_width true to render onto an image as wide as target, rather than
+ *  one which is only as big as the line's ink.
  */
 static PositionImage
-render_line (list<SubtitleString> subtitles, list<shared_ptr<Font> > fonts, dcp::Size target, DCPTime time)
+render_line (list<SubtitleString> subtitles, FontFiles font_files, dcp::Size target, float fade_factor, bool full_width)
 {
 	/* XXX: this method can only handle italic / bold changes mid-line,
 	   nothing else yet.
@@ -108,10 +249,62 @@ render_line (list<SubtitleString> subtitles, list<shared_ptr<Font> > fonts, dcp:
 		}
 	}
 
-	/* Make an empty bitmap as wide as target and at
-	   least tall enough for this subtitle.
+	/* This may be called from the player and from the prerenderer at the same time, but
+	   the Pango layout and drawing below use the global fontconfig configuration, which
+	   another thread may be adding fonts to.  Hold fc_mutex for all of it.
+	*/
+	boost::mutex::scoped_lock lm (fc_mutex);
+
+	string const font_name = font_name_for (font_files);
+	FcConfigSetCurrent (fc_config);
+
+	/* Lay the subtitle out using a context which is like the one that we will draw with,
+	   so that we can find out how big the image that we draw on needs to be.
 	*/
+	Cairo::RefPtr<Cairo::ImageSurface> measure_surface = Cairo::ImageSurface::create (Cairo::FORMAT_ARGB32, 1, 1);
+	Cairo::RefPtr<Cairo::Context> measure_context = Cairo::Context::create (measure_surface);
+
+	Glib::RefPtr<Pango::Layout> layout = Pango::Layout::create (measure_context);
 
+	layout->set_alignment (Pango::ALIGN_LEFT);
+
+	Pango::FontDescription font (font_name);
+	layout->set_font_description (font);
+	layout->set_markup (marked_up (subtitles, target.height, fade_factor));
+
+	measure_context->scale (xscale, yscale);
+	layout->update_from_cairo_context (measure_context);
+
+	/* Shuffle the subtitle over very slightly if it has a border so that the left-hand
+	   side of the first character's border is not cut off.
+	*/
+	int const x_offset = subtitles.front().effect() == dcp::BORDER ? (target.width / 600.0) : 0;
+	/* Move down a bit so that accents on capital letters can be seen */
+	int const y_offset = target.height / 100.0;
+
+	double const outline_width = subtitles.front().outline_width * target.width / 2048.0;
+
+	/* Area that we will draw on, in user space; first the text... */
+	Pango::Rectangle const ink = layout->get_pixel_ink_extents ();
+	double ink_left = x_offset + ink.get_x ();
+	double ink_top = y_offset + ink.get_y ();
+	double ink_right = ink_left + ink.get_width ();
+	double ink_bottom = ink_top + ink.get_height ();
+
+	/* ...then the effect... */
+	if (subtitles.front().effect() == dcp::SHADOW) {
+		ink_right += 4;
+		ink_bottom += 4;
+	} else if (subtitles.front().effect() == dcp::BORDER) {
+		ink_left -= outline_width / 2;
+		ink_top -= outline_width / 2;
+		ink_right += outline_width / 2;
+		ink_bottom += outline_width / 2;
+	}
+
+	/* Everything is clipped to an area as wide as target and at least tall
+	   enough for this subtitle.
+	*/
 	int largest = 0;
 	BOOST_FOREACH (dcp::SubtitleString const & i, subtitles) {
 		largest = max (largest, i.size());
@@ -123,7 +316,21 @@ render_line (list<SubtitleString> subtitles, list<shared_ptr<Font> > fonts, dcp:
 	/* ...and add a bit more for luck */
 	height += target.height / 11;
 
-	shared_ptr<Image> image (new Image (AV_PIX_FMT_RGBA, dcp::Size (target.width, height), false));
+	/* Area to draw on in pixels, with a little more for anti-aliasing.  That is added
+	   after scaling so that it is the same number of pixels whatever the scale.
+	*/
+	int left = 0;
+	int top = 0;
+	int right = target.width;
+	int bottom = height;
+	if (!full_width) {
+		left = max (0, min (target.width - 1, int (floor (ink_left * xscale)) - 2));
+		top = max (0, min (height - 1, int (floor (ink_top * yscale)) - 2));
+		right = max (left + 1, min (target.width, int (ceil (ink_right * xscale)) + 2));
+		bottom = max (top + 1, min (height, int (ceil (ink_bottom * yscale)) + 2));
+	}
+
+	shared_ptr<Image> image (new Image (AV_PIX_FMT_RGBA, dcp::Size (right - left, bottom - top), false));
 	image->make_black ();
 
 #ifdef DCPOMATIC_HAVE_FORMAT_STRIDE_FOR_WIDTH
@@ -147,127 +354,13 @@ render_line (list<SubtitleString> subtitles, list<shared_ptr<Font> > fonts, dcp:
 		);
 #endif
 
-	Cairo::RefPtr<Cairo::Context> context = Cairo::Context::create (surface);
-
-	if (!fc_config) {
-		fc_config = FcConfigCreate ();
-	}
-
-	FontFiles font_files;
-
-	try {
-		font_files.set (FontFiles::NORMAL, shared_path () / "LiberationSans-Regular.ttf");
-		font_files.set (FontFiles::ITALIC, shared_path () / "LiberationSans-Italic.ttf");
-		font_files.set (FontFiles::BOLD, shared_path () / "LiberationSans-Bold.ttf");
-	} catch (boost::filesystem::filesystem_error& e) {
-
-	}
-
-	/* Hack: try the debian/ubuntu locations if getting the shared path failed */
-
-	if (!font_files.get(FontFiles::NORMAL) || !boost::filesystem::exists(font_files.get(FontFiles::NORMAL).get())) {
-		font_files.set (FontFiles::NORMAL, "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf");
-	}
-	if (!font_files.get(FontFiles::ITALIC) || !boost::filesystem::exists(font_files.get(FontFiles::ITALIC).get())) {
-		font_files.set (FontFiles::ITALIC, "/usr/share/fonts/truetype/liberation/LiberationSans-Italic.ttf");
-	}
-	if (!font_files.get(FontFiles::BOLD) || !boost::filesystem::exists(font_files.get(FontFiles::BOLD).get())) {
-		font_files.set (FontFiles::BOLD, "/usr/share/fonts/truetype/liberation/LiberationSans-Bold.ttf");
-	}
-
-	BOOST_FOREACH (shared_ptr<Font> i, fonts) {
-		if (i->id() == subtitles.front().font() && i->file(FontFiles::NORMAL)) {
-			font_files = i->files ();
-		}
-	}
-
-	list<pair<FontFiles, string> >::const_iterator existing = fc_config_fonts.begin ();
-	while (existing != fc_config_fonts.end() && existing->first != font_files) {
-		++existing;
-	}
-
-	string font_name;
-	if (existing != fc_config_fonts.end ()) {
-		font_name = existing->second;
-	} else {
-		/* Make this font available to DCP-o-matic */
-		for (int i = 0; i < FontFiles::VARIANTS; ++i) {
-			if (font_files.get(static_cast<FontFiles::Variant>(i))) {
-				FcConfigAppFontAddFile (
-					fc_config,
-					reinterpret_cast<FcChar8 const *> (font_files.get(static_cast<FontFiles::Variant>(i)).get().string().c_str())
-					);
-			}
-		}
-
-		FcPattern* pattern = FcPatternBuild (
-			0, FC_FILE, FcTypeString, font_files.get(FontFiles::NORMAL).get().string().c_str(), static_cast<char *> (0)
-			);
-		FcObjectSet* object_set = FcObjectSetBuild (FC_FAMILY, FC_STYLE, FC_LANG, FC_FILE, static_cast<char *> (0));
-		FcFontSet* font_set = FcFontList (fc_config, pattern, object_set);
-		if (font_set) {
-			for (int i = 0; i < font_set->nfont; ++i) {
-				FcPattern* font = font_set->fonts[i];
-				FcChar8* file;
-				FcChar8* family;
-				FcChar8* style;
-				if (
-					FcPatternGetString (font, FC_FILE, 0, &file) == FcResultMatch &&
-					FcPatternGetString (font, FC_FAMILY, 0, &family) == FcResultMatch &&
-					FcPatternGetString (font, FC_STYLE, 0, &style) == FcResultMatch
-					) {
-					font_name = reinterpret_cast<char const *> (family);
-				}
-			}
-
-			FcFontSetDestroy (font_set);
-		}
-
-		FcObjectSetDestroy (object_set);
-		FcPatternDestroy (pattern);
-
-		fc_config_fonts.push_back (make_pair (font_files, font_name));
-	}
-
-	FcConfigSetCurrent (fc_config);
-
-	Glib::RefPtr<Pango::Layout> layout = Pango::Layout::create (context);
-
-	layout->set_alignment (Pango::ALIGN_LEFT);
-
-	context->set_line_width (1);
-
-	/* Compute fade factor */
-	float fade_factor = 1;
-
-	DCPTime const fade_in_start = DCPTime::from_seconds (subtitles.front().in().as_seconds ());
-	DCPTime const fade_in_end = fade_in_start + DCPTime::from_seconds (subtitles.front().fade_up_time().as_seconds ());
-	DCPTime const fade_out_end =  DCPTime::from_seconds (subtitles.front().out().as_seconds ());
-	DCPTime const fade_out_start = fade_out_end - DCPTime::from_seconds (subtitles.front().fade_down_time().as_seconds ());
-	if (fade_in_start <= time && time <= fade_in_end && fade_in_start != fade_in_end) {
-		fade_factor = DCPTime(time - fade_in_start).seconds() / DCPTime(fade_in_end - fade_in_start).seconds();
-	} else if (fade_out_start <= time && time <= fade_out_end && fade_out_start != fade_out_end) {
-		fade_factor = 1 - DCPTime(time - fade_out_start).seconds() / DCPTime(fade_out_end - fade_out_start).seconds();
-	} else if (time < fade_in_start || time > fade_out_end) {
-		fade_factor = 0;
-	}
-
-	/* Render the subtitle at the top left-hand corner of image */
-
-	Pango::FontDescription font (font_name);
-	layout->set_font_description (font);
-	layout->set_markup (marked_up (subtitles, target.height, fade_factor));
+	/* Move the drawing so that the top-left of image is at (left, top) */
+	surface->set_device_offset (-left, -top);
 
+	Cairo::RefPtr<Cairo::Context> context = Cairo::Context::create (surface);
 	context->scale (xscale, yscale);
 	layout->update_from_cairo_context (context);
 
-	/* Shuffle the subtitle over very slightly if it has a border so that the left-hand
-	   side of the first character's border is not cut off.
-	*/
-	int const x_offset = subtitles.front().effect() == dcp::BORDER ? (target.width / 600.0) : 0;
-	/* Move down a bit so that accents on capital letters can be seen */
-	int const y_offset = target.height / 100.0;
-
 	if (subtitles.front().effect() == dcp::SHADOW) {
 		/* Drop-shadow effect */
 		set_source_rgba (context, subtitles.front().effect_colour(), fade_factor);
@@ -279,7 +372,7 @@ render_line (list<SubtitleString> subtitles, list<shared_ptr<Font> > fonts, dcp:
 	if (subtitles.front().effect() == dcp::BORDER) {
 		/* Border effect; stroke the subtitle with a large (arbitrarily chosen) line width */
 		set_source_rgba (context, subtitles.front().effect_colour(), fade_factor);
-		context->set_line_width (subtitles.front().outline_width * target.width / 2048.0);
+		context->set_line_width (outline_width);
 		context->set_line_join (Cairo::LINE_JOIN_ROUND);
 		context->move_to (x_offset, y_offset);
 		layout->add_to_cairo_context (context);
@@ -339,27 +432,191 @@ render_line (list<SubtitleString> subtitles, list<shared_ptr<Font> > fonts, dcp:
 		break;
 	}
 
-	return PositionImage (image, Position<int> (max (0, x), max (0, y)));
+	return PositionImage (image, Position<int> (max (0, x) + left, max (0, y) + top));
 }
 
-/** @param time Time of the frame that these subtitles are going on */
-list<PositionImage>
-render_subtitles (list<SubtitleString> subtitles, list<shared_ptr<Font> > fonts, dcp::Size target, DCPTime time)
+/** A line that we have rendered, and the things that its rendering depends on */
+struct RenderedLine
+{
+	list<SubtitleString> subtitles;
+	FontFiles font_files;
+	dcp::Size target;
+	float fade_factor;
+	PositionImage image;
+};
+
+static boost::mutex rendered_lines_mutex;
+/** Condition which is signalled when a line has been moved out of rendering_lines */
+static boost::condition rendered_lines_condition;
+/** Lines that we have recently rendered, most-recently-used first */
+static list<RenderedLine> rendered_lines;
+/** Lines which some thread is rendering now; their images are not yet set */
+static list<RenderedLine> rendering_lines;
+/** Total size of the images in rendered_lines, in bytes */
+static int64_t rendered_lines_bytes = 0;
+/** Maximum total size of the images in rendered_lines, in bytes */
+static int64_t const rendered_lines_max_bytes = 64 * 1024 * 1024;
+/** Number of lines that render_line_cached() has had to render */
+static int rendered_lines_count = 0;
+
+static int64_t
+image_bytes (shared_ptr<const Image> image)
+{
+	return int64_t (image->stride()[0]) * image->size().height;
+}
+
+static bool
+same_subtitles (list<SubtitleString> const & a, list<SubtitleString> const & b)
+{
+	if (a.size() != b.size()) {
+		return false;
+	}
+
+	list<SubtitleString>::const_iterator i = a.begin ();
+	list<SubtitleString>::const_iterator j = b.begin ();
+	while (i != a.end ()) {
+		if (!(static_cast<dcp::SubtitleString const &> (*i) == static_cast<dcp::SubtitleString const &> (*j)) || i->outline_width != j->outline_width) {
+			return false;
+		}
+		++i;
+		++j;
+	}
+
+	return true;
+}
+
+/** @return true if `line' is (or will be) a rendering of some subtitles in a particular way */
+static bool
+is_rendering_of (RenderedLine const & line, list<SubtitleString> const & subtitles, FontFiles const & font_files, dcp::Size target, float fade_factor)
+{
+	return line.target == target &&
+		line.fade_factor == fade_factor &&
+		!(line.font_files != font_files) &&
+		same_subtitles (line.subtitles, subtitles);
+}
+
+/** Render a line, or fetch it from rendered_lines if we have rendered it
+ *  in the same way before.  If another thread is rendering the same line
+ *  at the moment we wait for it to finish rather than doing the work again.
+ *  Parameters are as for render_line().
+ */
+static PositionImage
+render_line_cached (list<SubtitleString> subtitles, FontFiles font_files, dcp::Size target, float fade_factor)
+{
+	list<RenderedLine>::iterator rendering;
+
+	{
+		boost::mutex::scoped_lock lm (rendered_lines_mutex);
+		while (true) {
+			for (list<RenderedLine>::iterator i = rendered_lines.begin(); i != rendered_lines.end(); ++i) {
+				if (is_rendering_of (*i, subtitles, font_files, target, fade_factor)) {
+					rendered_lines.splice (rendered_lines.begin(), rendered_lines, i);
+					return rendered_lines.front().image;
+				}
+			}
+
+			bool busy = false;
+			for (list<RenderedLine>::iterator i = rendering_lines.begin(); i != rendering_lines.end(); ++i) {
+				if (is_rendering_of (*i, subtitles, font_files, target, fade_factor)) {
+					busy = true;
+				}
+			}
+
+			if (!busy) {
+				break;
+			}
+
+			/* Someone else is rendering this line; wait for them, then look again
+			   (if they failed it won't be in rendered_lines, and we will have a go ourselves).
+			*/
+			rendered_lines_condition.wait (lm);
+		}
+
+		RenderedLine line;
+		line.subtitles = subtitles;
+		line.font_files = font_files;
+		line.target = target;
+		line.fade_factor = fade_factor;
+		rendering = rendering_lines.insert (rendering_lines.end(), line);
+	}
+
+	/* Render without the lock held so that other threads can use the cache meanwhile */
+	try {
+		rendering->image = render_line (subtitles, font_files, target, fade_factor, false);
+	} catch (...) {
+		boost::mutex::scoped_lock lm (rendered_lines_mutex);
+		rendering_lines.erase (rendering);
+		rendered_lines_condition.notify_all ();
+		throw;
+	}
+
+	boost::mutex::scoped_lock lm (rendered_lines_mutex);
+	rendered_lines.splice (rendered_lines.begin(), rendering_lines, rendering);
+	rendered_lines_condition.notify_all ();
+	++rendered_lines_count;
+	PositionImage const image = rendered_lines.front().image;
+	rendered_lines_bytes += image_bytes (image.image);
+	while (rendered_lines_bytes > rendered_lines_max_bytes && rendered_lines.size() > 1) {
+		rendered_lines_bytes -= image_bytes (rendered_lines.back().image.image);
+		rendered_lines.pop_back ();
+	}
+
+	return image;
+}
+
+/** @return number of lines that have been rendered, rather than found already rendered, so far */
+int
+rendered_line_count ()
+{
+	boost::mutex::scoped_lock lm (rendered_lines_mutex);
+	return rendered_lines_count;
+}
+
+typedef PositionImage (*LineRenderer) (list<SubtitleString>, FontFiles, dcp::Size, float);
+
+/** Split some subtitles into lines and render each one with a given function */
+static list<PositionImage>
+render_lines (list<SubtitleString> subtitles, list<shared_ptr<Font> > fonts, dcp::Size target, DCPTime time, LineRenderer renderer)
 {
 	list<SubtitleString> pending;
 	list<PositionImage> images;
 
 	BOOST_FOREACH (SubtitleString const & i, subtitles) {
 		if (!pending.empty() && fabs (i.v_position() - pending.back().v_position()) > 1e-4) {
-			images.push_back (render_line (pending, fonts, target, time));
+			images.push_back (renderer (pending, font_files_for (pending.front(), fonts), target, fade_factor_for (pending.front(), time)));
 			pending.clear ();
 		}
 		pending.push_back (i);
 	}
 
 	if (!pending.empty ()) {
-		images.push_back (render_line (pending, fonts, target, time));
+		images.push_back (renderer (pending, font_files_for (pending.front(), fonts), target, fade_factor_for (pending.front(), time)));
 	}
 
 	return images;
 }
+
+/** @param time Time of the frame that these subtitles are going on.
+ *  @return Rendered lines.  These may be shared with other callers, so they must not be modified.
+ */
+list<PositionImage>
+render_subtitles (list<SubtitleString> subtitles, list<shared_ptr<Font> > fonts, dcp::Size target, DCPTime time)
+{
+	return render_lines (subtitles, fonts, target, time, &render_line_cached);
+}
+
+static PositionImage
+render_line_full_width (list<SubtitleString> subtitles, FontFiles font_files, dcp::Size target, float fade_factor)
+{
+	return render_line (subtitles, font_files, target, fade_factor, true);
+}
+
+/** Render subtitles as render_subtitles() does, but without the cache and onto images
+ *  which are as wide as the target rather than only as big as each line's ink.  This
+ *  is slower, and is only here so that tests can check that the two give the same pixels.
+ */
+list<PositionImage>
+render_subtitles_full_width (list<SubtitleString> subtitles, list<shared_ptr<Font> > fonts, dcp::Size target, DCPTime time)
+{
+	return render_lines (subtitles, fonts, target, time, &render_line_full_width);
+}
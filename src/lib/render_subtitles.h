@@ -29,3 +29,7 @@ std::string marked_up (std::list<SubtitleString> subtitles, int target_height, f
 std::list<PositionImage> render_subtitles (
 	std::list<SubtitleString>, std::list<boost::shared_ptr<Font> > fonts, dcp::Size, DCPTime
 	);
+std::list<PositionImage> render_subtitles_full_width (
+	std::list<SubtitleString>, std::list<boost::shared_ptr<Font> > fonts, dcp::Size, DCPTime
+	);
+int rendered_line_count ();
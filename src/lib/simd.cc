@@ -0,0 +1,63 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "simd.h"
+#include <boost/thread/mutex.hpp>
+#include <boost/optional.hpp>
+
+static boost::mutex simd_mutex;
+static boost::optional<SIMDLevel> simd;
+
+/** @return the best instruction set that this CPU supports */
+SIMDLevel
+simd_level_supported ()
+{
+#ifdef DCPOMATIC_HAVE_SIMD_KERNELS
+	__builtin_cpu_init ();
+	if (__builtin_cpu_supports ("avx2")) {
+		return SIMD_AVX2;
+	} else if (__builtin_cpu_supports ("sse2")) {
+		return SIMD_SSE2;
+	}
+#endif
+	return SIMD_NONE;
+}
+
+/** @return the instruction set that image processing kernels should use */
+SIMDLevel
+simd_level ()
+{
+	boost::mutex::scoped_lock lm (simd_mutex);
+	if (!simd) {
+		simd = simd_level_supported ();
+	}
+	return simd.get ();
+}
+
+/** Override the instruction set to use; this is intended for tests.
+ *  @param level Level to use; it will be reduced to what the CPU supports if necessary.
+ */
+void
+set_simd_level (SIMDLevel level)
+{
+	SIMDLevel const supported = simd_level_supported ();
+	boost::mutex::scoped_lock lm (simd_mutex);
+	simd = level > supported ? supported : level;
+}
@@ -0,0 +1,87 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/** @file  src/lib/simd.h
+ *  @brief Run-time choice of vectorised code paths.
+ */
+
+#ifndef DCPOMATIC_SIMD_H
+#define DCPOMATIC_SIMD_H
+
+/** Instruction sets that we may use for image processing kernels, in order of preference */
+enum SIMDLevel
+{
+	/** plain C++ */
+	SIMD_NONE,
+	SIMD_SSE2,
+	SIMD_AVX2
+};
+
+extern SIMDLevel simd_level ();
+extern void set_simd_level (SIMDLevel level);
+extern SIMDLevel simd_level_supported ();
+
+/* DCPOMATIC_TARGET_SSE2 and DCPOMATIC_TARGET_AVX2 mark functions that should be
+   compiled (and vectorised) for a particular instruction set.  Such functions must
+   only be called if simd_level() says that the CPU can run them.
+*/
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DCPOMATIC_HAVE_SIMD_KERNELS 1
+#ifdef __clang__
+#define DCPOMATIC_TARGET_SSE2 __attribute__((target("sse2")))
+#define DCPOMATIC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define DCPOMATIC_TARGET_SSE2 __attribute__((target("sse2"), optimize("tree-vectorize")))
+#define DCPOMATIC_TARGET_AVX2 __attribute__((target("avx2"), optimize("tree-vectorize")))
+#endif
+#endif
+
+/* Mark small helpers used by kernels so that they are always inlined, and hence
+   compiled for the instruction set of the kernel that uses them.
+*/
+#ifdef __GNUC__
+#define DCPOMATIC_KERNEL_INLINE inline __attribute__((always_inline))
+#else
+#define DCPOMATIC_KERNEL_INLINE inline
+#endif
+
+/* DCPOMATIC_KERNEL (name, params, args) makes static functions name_none, name_sse2 and
+   name_avx2, each of which calls name_body (args), where name_body is an inline function.
+   DCPOMATIC_KERNEL_CALL (name, level, args) calls whichever of those suits a SIMDLevel.
+*/
+#ifdef DCPOMATIC_HAVE_SIMD_KERNELS
+#define DCPOMATIC_KERNEL(name, params, args) \
+	static void name##_none params { name##_body args; } \
+	DCPOMATIC_TARGET_SSE2 static void name##_sse2 params { name##_body args; } \
+	DCPOMATIC_TARGET_AVX2 static void name##_avx2 params { name##_body args; }
+#define DCPOMATIC_KERNEL_CALL(name, level, args) \
+	switch (level) { \
+	case SIMD_AVX2: name##_avx2 args; break; \
+	case SIMD_SSE2: name##_sse2 args; break; \
+	default: name##_none args; break; \
+	}
+#else
+#define DCPOMATIC_KERNEL(name, params, args) \
+	static void name##_none params { name##_body args; }
+#define DCPOMATIC_KERNEL_CALL(name, level, args) \
+	name##_none args;
+#endif
+
+#endif
@@ -0,0 +1,147 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "subtitle_file_cache.h"
+#include <dcp/subtitle_asset.h>
+#include <sub/subtitle.h>
+
+using std::list;
+using std::pair;
+using std::vector;
+using std::make_pair;
+using boost::shared_ptr;
+
+SubtitleFileCache* SubtitleFileCache::_instance = 0;
+int const SubtitleFileCache::_max_files = 16;
+
+SubtitleFileCache::Key::Key (boost::filesystem::path file)
+	: path (file)
+	, modified (0)
+	, size (0)
+{
+	/* If the file can't be looked at the key won't match anything that was parsed
+	   successfully, and whoever is trying to read it will find out what is wrong.
+	*/
+	boost::system::error_code ec;
+	modified = boost::filesystem::last_write_time (file, ec);
+	if (ec) {
+		modified = 0;
+	}
+	size = boost::filesystem::file_size (file, ec);
+	if (ec) {
+		size = 0;
+	}
+}
+
+bool
+SubtitleFileCache::Key::operator== (Key const & other) const
+{
+	return path == other.path && modified == other.modified && size == other.size;
+}
+
+SubtitleFileCache::SubtitleFileCache ()
+	: _hits (0)
+{
+
+}
+
+template <class T>
+shared_ptr<const T>
+SubtitleFileCache::get (list<pair<Key, shared_ptr<const T> > >& files, boost::filesystem::path file)
+{
+	Key const key (file);
+
+	boost::mutex::scoped_lock lm (_mutex);
+	for (typename list<pair<Key, shared_ptr<const T> > >::iterator i = files.begin(); i != files.end(); ++i) {
+		if (i->first == key) {
+			/* Move it to the front */
+			files.splice (files.begin(), files, i);
+			++_hits;
+			return files.front().second;
+		}
+	}
+
+	return shared_ptr<const T> ();
+}
+
+template <class T>
+void
+SubtitleFileCache::put (list<pair<Key, shared_ptr<const T> > >& files, boost::filesystem::path file, shared_ptr<const T> data)
+{
+	Key const key (file);
+
+	boost::mutex::scoped_lock lm (_mutex);
+	for (typename list<pair<Key, shared_ptr<const T> > >::iterator i = files.begin(); i != files.end(); ++i) {
+		if (i->first.path == file) {
+			/* Anything we had for this file is either the same or out of date */
+			files.erase (i);
+			break;
+		}
+	}
+
+	files.push_front (make_pair (key, data));
+	while (int (files.size()) > _max_files) {
+		files.pop_back ();
+	}
+}
+
+/** @return Parsed subtitles from a DCP XML subtitle file, or 0 if we do not have them for
+ *  the current version of the file.
+ */
+shared_ptr<const dcp::SubtitleAsset>
+SubtitleFileCache::get_dcp (boost::filesystem::path file)
+{
+	return get (_dcp, file);
+}
+
+/** Keep the result of parsing a DCP XML subtitle file */
+void
+SubtitleFileCache::put_dcp (boost::filesystem::path file, shared_ptr<const dcp::SubtitleAsset> asset)
+{
+	put (_dcp, file, asset);
+}
+
+/** @return Parsed subtitles from a SubRip or SSA file, or 0 if we do not have them for
+ *  the current version of the file.
+ */
+shared_ptr<const vector<sub::Subtitle> >
+SubtitleFileCache::get_text (boost::filesystem::path file)
+{
+	return get (_text, file);
+}
+
+/** Keep the result of parsing a SubRip or SSA file */
+void
+SubtitleFileCache::put_text (boost::filesystem::path file, shared_ptr<const vector<sub::Subtitle> > subtitles)
+{
+	put (_text, file, subtitles);
+}
+
+SubtitleFileCache *
+SubtitleFileCache::instance ()
+{
+	static boost::mutex instance_mutex;
+	boost::mutex::scoped_lock lm (instance_mutex);
+	if (!_instance) {
+		_instance = new SubtitleFileCache ();
+	}
+
+	return _instance;
+}
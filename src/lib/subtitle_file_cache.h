@@ -0,0 +1,101 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DCPOMATIC_SUBTITLE_FILE_CACHE_H
+#define DCPOMATIC_SUBTITLE_FILE_CACHE_H
+
+#include <boost/shared_ptr.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/cstdint.hpp>
+#include <ctime>
+#include <list>
+#include <vector>
+
+namespace dcp {
+	class SubtitleAsset;
+}
+
+namespace sub {
+	class Subtitle;
+}
+
+/** @class SubtitleFileCache
+ *  @brief A process-wide cache of parsed subtitle files.
+ *
+ *  Decoders for subtitle content are re-made whenever the player's pieces are
+ *  set up again, and parsing large subtitle files can be slow, so the results are
+ *  kept here and shared.  Entries are keyed on a file's path, modification time
+ *  and size so that a file which is changed on disk will be parsed again.
+ *
+ *  Cached data is shared between users and must not be modified.
+ */
+class SubtitleFileCache : public boost::noncopyable
+{
+public:
+	boost::shared_ptr<const dcp::SubtitleAsset> get_dcp (boost::filesystem::path file);
+	void put_dcp (boost::filesystem::path file, boost::shared_ptr<const dcp::SubtitleAsset> asset);
+
+	boost::shared_ptr<const std::vector<sub::Subtitle> > get_text (boost::filesystem::path file);
+	void put_text (boost::filesystem::path file, boost::shared_ptr<const std::vector<sub::Subtitle> > subtitles);
+
+	/** @return number of times that a cached file has been re-used */
+	int hits () const {
+		boost::mutex::scoped_lock lm (_mutex);
+		return _hits;
+	}
+
+	static SubtitleFileCache* instance ();
+
+private:
+	SubtitleFileCache ();
+
+	/** The things which identify a particular version of a file */
+	struct Key
+	{
+		explicit Key (boost::filesystem::path file);
+
+		boost::filesystem::path path;
+		std::time_t modified;
+		boost::uintmax_t size;
+
+		bool operator== (Key const & other) const;
+	};
+
+	template <class T>
+	boost::shared_ptr<const T> get (std::list<std::pair<Key, boost::shared_ptr<const T> > >& files, boost::filesystem::path file);
+
+	template <class T>
+	void put (std::list<std::pair<Key, boost::shared_ptr<const T> > >& files, boost::filesystem::path file, boost::shared_ptr<const T> data);
+
+	mutable boost::mutex _mutex;
+	/** parsed DCP XML subtitle files, most recently used first */
+	std::list<std::pair<Key, boost::shared_ptr<const dcp::SubtitleAsset> > > _dcp;
+	/** parsed SubRip / SSA subtitle files, in order of start time; most recently used first */
+	std::list<std::pair<Key, boost::shared_ptr<const std::vector<sub::Subtitle> > > > _text;
+	int _hits;
+
+	/** maximum number of files of each type to keep */
+	static int const _max_files;
+	static SubtitleFileCache* _instance;
+};
+
+#endif
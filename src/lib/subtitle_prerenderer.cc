@@ -0,0 +1,111 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "subtitle_prerenderer.h"
+#include "render_subtitles.h"
+#include "font.h"
+#include <boost/bind.hpp>
+
+using std::list;
+using boost::shared_ptr;
+using boost::bind;
+
+int const SubtitlePrerenderer::_max_jobs = 64;
+
+SubtitlePrerenderer::SubtitlePrerenderer ()
+	: _stop_thread (false)
+{
+	_thread = new boost::thread (bind (&SubtitlePrerenderer::thread, this));
+}
+
+SubtitlePrerenderer::~SubtitlePrerenderer ()
+{
+	{
+		boost::mutex::scoped_lock lm (_mutex);
+		_stop_thread = true;
+	}
+
+	_thread->interrupt ();
+	try {
+		_thread->join ();
+	} catch (boost::thread_interrupted& e) {
+		/* No problem */
+	}
+	delete _thread;
+}
+
+/** Ask for some subtitles to be rendered in the background.
+ *  @param time Time of the frame that the subtitles will be rendered for; this affects any fading.
+ *  Other parameters are as for render_subtitles().
+ */
+void
+SubtitlePrerenderer::add (list<SubtitleString> subtitles, list<shared_ptr<Font> > fonts, dcp::Size target, DCPTime time)
+{
+	Job job;
+	job.subtitles = subtitles;
+	job.fonts = fonts;
+	job.target = target;
+	job.time = time;
+
+	boost::mutex::scoped_lock lm (_mutex);
+	_jobs.push_back (job);
+	/* If we are a long way behind the oldest jobs are probably no longer of any use */
+	while (int (_jobs.size()) > _max_jobs) {
+		_jobs.pop_front ();
+	}
+	_summon.notify_all ();
+}
+
+/** Forget about any jobs that have not yet been started; e.g. after a seek */
+void
+SubtitlePrerenderer::clear ()
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	_jobs.clear ();
+}
+
+void
+SubtitlePrerenderer::thread ()
+{
+	while (true) {
+		boost::mutex::scoped_lock lm (_mutex);
+		while (_jobs.empty() && !_stop_thread) {
+			_summon.wait (lm);
+		}
+
+		if (_stop_thread) {
+			return;
+		}
+
+		Job job = _jobs.front ();
+		_jobs.pop_front ();
+		lm.unlock ();
+
+		try {
+			render_subtitles (job.subtitles, job.fonts, job.target, job.time);
+		} catch (boost::thread_interrupted &) {
+			throw;
+		} catch (...) {
+			/* Never mind; the subtitles will be rendered again when they are needed,
+			   and whoever does that will hear about the problem.
+			*/
+		}
+	}
+}
@@ -0,0 +1,81 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DCPOMATIC_SUBTITLE_PRERENDERER_H
+#define DCPOMATIC_SUBTITLE_PRERENDERER_H
+
+#include "subtitle_string.h"
+#include "dcpomatic_time.h"
+#include <dcp/util.h>
+#include <boost/thread.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/noncopyable.hpp>
+#include <list>
+
+class Font;
+
+/** @class SubtitlePrerenderer
+ *  @brief A thread which renders text subtitles ahead of when they are needed.
+ *
+ *  Subtitles given to add() are rendered with render_subtitles() in the background,
+ *  which leaves the results in its cache; when the same subtitles are later rendered
+ *  for a frame they are found there (or, if they are still being rendered, waited for)
+ *  rather than being rendered on the caller's thread.
+ */
+class SubtitlePrerenderer : public boost::noncopyable
+{
+public:
+	SubtitlePrerenderer ();
+	~SubtitlePrerenderer ();
+
+	void add (std::list<SubtitleString> subtitles, std::list<boost::shared_ptr<Font> > fonts, dcp::Size target, DCPTime time);
+	void clear ();
+
+	/** @return number of jobs which have not yet been started */
+	int pending () const {
+		boost::mutex::scoped_lock lm (_mutex);
+		return _jobs.size ();
+	}
+
+private:
+	void thread ();
+
+	/** Some subtitles to render, and the things that their rendering depends on */
+	struct Job
+	{
+		std::list<SubtitleString> subtitles;
+		std::list<boost::shared_ptr<Font> > fonts;
+		dcp::Size target;
+		DCPTime time;
+	};
+
+	boost::thread* _thread;
+	/** mutex to protect _jobs and _stop_thread */
+	mutable boost::mutex _mutex;
+	boost::condition _summon;
+	/** jobs which have not yet been started, oldest first */
+	std::list<Job> _jobs;
+	bool _stop_thread;
+
+	/** maximum number of jobs to queue */
+	static int const _max_jobs;
+};
+
+#endif
@@ -0,0 +1,128 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "sws_context_cache.h"
+#include "dcpomatic_assert.h"
+extern "C" {
+#include <libswscale/swscale.h>
+}
+#include <stdexcept>
+
+#include "i18n.h"
+
+using std::list;
+using std::pair;
+using std::make_pair;
+using std::runtime_error;
+
+SwsContextCache* SwsContextCache::_instance = 0;
+int const SwsContextCache::_max_idle = 32;
+
+bool
+SwsContextCache::Key::operator== (Key const & other) const
+{
+	return in_size == other.in_size && in_format == other.in_format
+		&& out_size == other.out_size && out_format == other.out_format
+		&& yuv_to_rgb == other.yuv_to_rgb && flags == other.flags;
+}
+
+SwsContextCache::SwsContextCache ()
+	: _created (0)
+	, _reused (0)
+{
+
+}
+
+SwsContextCache::~SwsContextCache ()
+{
+	for (list<pair<Key, SwsContext*> >::iterator i = _idle.begin(); i != _idle.end(); ++i) {
+		sws_freeContext (i->second);
+	}
+}
+
+/** @return A context for the given parameters, either from the cache or
+ *  newly-created.  It should be given back with put() after use.
+ */
+SwsContext*
+SwsContextCache::get (Key const & key)
+{
+	{
+		boost::mutex::scoped_lock lm (_mutex);
+		for (list<pair<Key, SwsContext*> >::iterator i = _idle.begin(); i != _idle.end(); ++i) {
+			if (i->first == key) {
+				SwsContext* c = i->second;
+				_idle.erase (i);
+				++_reused;
+				return c;
+			}
+		}
+	}
+
+	SwsContext* c = sws_getContext (
+		key.in_size.width, key.in_size.height, key.in_format,
+		key.out_size.width, key.out_size.height, key.out_format,
+		key.flags, 0, 0, 0
+		);
+
+	if (!c) {
+		throw runtime_error (N_("Could not allocate SwsContext"));
+	}
+
+	DCPOMATIC_ASSERT (key.yuv_to_rgb < dcp::YUV_TO_RGB_COUNT);
+	int const lut[dcp::YUV_TO_RGB_COUNT] = {
+		SWS_CS_ITU601,
+		SWS_CS_ITU709
+	};
+
+	sws_setColorspaceDetails (
+		c,
+		sws_getCoefficients (lut[key.yuv_to_rgb]), 0,
+		sws_getCoefficients (lut[key.yuv_to_rgb]), 0,
+		0, 1 << 16, 1 << 16
+		);
+
+	boost::mutex::scoped_lock lm (_mutex);
+	++_created;
+	return c;
+}
+
+/** Give back a context that was obtained with get() */
+void
+SwsContextCache::put (Key const & key, SwsContext* context)
+{
+	boost::mutex::scoped_lock lm (_mutex);
+	_idle.push_front (make_pair (key, context));
+	while (int (_idle.size()) > _max_idle) {
+		sws_freeContext (_idle.back().second);
+		_idle.pop_back ();
+	}
+}
+
+SwsContextCache *
+SwsContextCache::instance ()
+{
+	static boost::mutex instance_mutex;
+	boost::mutex::scoped_lock lm (instance_mutex);
+	if (!_instance) {
+		_instance = new SwsContextCache ();
+	}
+
+	return _instance;
+}
@@ -0,0 +1,123 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DCPOMATIC_SWS_CONTEXT_CACHE_H
+#define DCPOMATIC_SWS_CONTEXT_CACHE_H
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+}
+#include <dcp/types.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/noncopyable.hpp>
+#include <list>
+
+struct SwsContext;
+
+/** @class SwsContextCache
+ *  @brief A cache of swscale contexts, so that we need not make a new one
+ *  for every frame that we scale.
+ *
+ *  A context may only be used by one thread at a time, so callers get() one,
+ *  use it and then put() it back so that it can be used again.
+ */
+class SwsContextCache : public boost::noncopyable
+{
+public:
+	/** The parameters which go into making a context */
+	struct Key
+	{
+		Key (dcp::Size in_size_, AVPixelFormat in_format_, dcp::Size out_size_, AVPixelFormat out_format_, dcp::YUVToRGB yuv_to_rgb_, int flags_)
+			: in_size (in_size_)
+			, in_format (in_format_)
+			, out_size (out_size_)
+			, out_format (out_format_)
+			, yuv_to_rgb (yuv_to_rgb_)
+			, flags (flags_)
+		{}
+
+		dcp::Size in_size;
+		AVPixelFormat in_format;
+		dcp::Size out_size;
+		AVPixelFormat out_format;
+		dcp::YUVToRGB yuv_to_rgb;
+		int flags;
+
+		bool operator== (Key const & other) const;
+	};
+
+	/** @class Holder
+	 *  @brief Gets a context from the cache, and puts it back when it goes out of scope.
+	 */
+	class Holder : public boost::noncopyable
+	{
+	public:
+		explicit Holder (Key const & key)
+			: _key (key)
+			, _context (SwsContextCache::instance()->get (key))
+		{}
+
+		~Holder ()
+		{
+			SwsContextCache::instance()->put (_key, _context);
+		}
+
+		SwsContext* get () const {
+			return _context;
+		}
+
+	private:
+		Key _key;
+		SwsContext* _context;
+	};
+
+	SwsContext* get (Key const & key);
+	void put (Key const & key, SwsContext* context);
+
+	/** @return number of contexts that have been created */
+	int created () const {
+		boost::mutex::scoped_lock lm (_mutex);
+		return _created;
+	}
+
+	/** @return number of times that a cached context has been re-used */
+	int reused () const {
+		boost::mutex::scoped_lock lm (_mutex);
+		return _reused;
+	}
+
+	static SwsContextCache* instance ();
+
+private:
+	SwsContextCache ();
+	~SwsContextCache ();
+
+	mutable boost::mutex _mutex;
+	/** contexts which are not in use, most recently used first */
+	std::list<std::pair<Key, SwsContext*> > _idle;
+	int _created;
+	int _reused;
+
+	/** maximum number of idle contexts to keep */
+	static int const _max_idle;
+	static SwsContextCache* _instance;
+};
+
+#endif
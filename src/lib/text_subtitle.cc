@@ -22,11 +22,14 @@
 #include "cross.h"
 #include "exceptions.h"
 #include "text_subtitle_content.h"
+#include "subtitle_file_cache.h"
 #include <sub/subrip_reader.h>
 #include <sub/ssa_reader.h>
 #include <sub/collect.h>
 #include <unicode/ucsdet.h>
 #include <unicode/ucnv.h>
+#include <boost/foreach.hpp>
+#include <algorithm>
 #include <iostream>
 
 #include "i18n.h"
@@ -34,13 +37,24 @@
 using std::vector;
 using std::cout;
 using std::string;
+using std::max;
 using boost::shared_ptr;
 using boost::scoped_array;
 using dcp::Data;
 
-TextSubtitle::TextSubtitle (shared_ptr<const TextSubtitleContent> content)
+static bool
+starts_earlier (sub::Subtitle const & a, sub::Subtitle const & b)
+{
+	return a.from.all_as_seconds() < b.from.all_as_seconds();
+}
+
+/** Read and parse a SubRip or SSA file.
+ *  @return Its subtitles, in order of start time.
+ */
+static shared_ptr<vector<sub::Subtitle> >
+parse (boost::filesystem::path file)
 {
-	Data in (content->path (0));
+	Data in (file);
 
 	UErrorCode status = U_ZERO_ERROR;
 	UCharsetDetector* detector = ucsdet_open (&status);
@@ -69,7 +83,7 @@ TextSubtitle::TextSubtitle (shared_ptr<const TextSubtitleContent> content)
 
 	sub::Reader* reader = 0;
 
-	string ext = content->path(0).extension().string();
+	string ext = file.extension().string();
 	transform (ext.begin(), ext.end(), ext.begin(), ::tolower);
 
 	if (ext == ".srt") {
@@ -78,19 +92,43 @@ TextSubtitle::TextSubtitle (shared_ptr<const TextSubtitleContent> content)
 		reader = new sub::SSAReader (utf8.get());
 	}
 
+	shared_ptr<vector<sub::Subtitle> > subtitles (new vector<sub::Subtitle> ());
 	if (reader) {
-		_subtitles = sub::collect<vector<sub::Subtitle> > (reader->subtitles ());
+		*subtitles = sub::collect<vector<sub::Subtitle> > (reader->subtitles ());
 	}
 
 	delete reader;
+
+	/* Files are not always in time order; we want them to be, and this also keeps
+	   subtitles which start at the same time in the order that they were in the file.
+	*/
+	stable_sort (subtitles->begin(), subtitles->end(), starts_earlier);
+	return subtitles;
+}
+
+TextSubtitle::TextSubtitle (shared_ptr<const TextSubtitleContent> content)
+{
+	boost::filesystem::path const file = content->path (0);
+	_subtitles = SubtitleFileCache::instance()->get_text (file);
+	if (!_subtitles) {
+		shared_ptr<vector<sub::Subtitle> > parsed = parse (file);
+		SubtitleFileCache::instance()->put_text (file, parsed);
+		_subtitles = parsed;
+	}
+
+	ContentTime latest;
+	BOOST_FOREACH (sub::Subtitle const & i, *_subtitles) {
+		latest = max (latest, ContentTime::from_seconds (i.to.all_as_seconds ()));
+		_latest_to.push_back (latest);
+	}
 }
 
 ContentTime
 TextSubtitle::length () const
 {
-	if (_subtitles.empty ()) {
+	if (_latest_to.empty ()) {
 		return ContentTime ();
 	}
 
-	return ContentTime::from_seconds (_subtitles.back().to.all_as_seconds ());
+	return _latest_to.back ();
 }
@@ -40,7 +40,14 @@ public:
 	ContentTime length () const;
 
 protected:
-	std::vector<sub::Subtitle> _subtitles;
+	/** Our subtitles, in order of start time; these may be shared with other users
+	 *  of the same file.
+	 */
+	boost::shared_ptr<const std::vector<sub::Subtitle> > _subtitles;
+	/** The latest end time of _subtitles[0] to _subtitles[i], for each i; this never
+	 *  decreases, so it can be binary-searched to find where to start after a seek.
+	 */
+	std::vector<ContentTime> _latest_to;
 };
 
 #endif
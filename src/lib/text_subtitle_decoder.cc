@@ -23,6 +23,7 @@
 #include "subtitle_content.h"
 #include <dcp/subtitle_string.h>
 #include <boost/foreach.hpp>
+#include <algorithm>
 #include <iostream>
 
 using std::list;
@@ -30,6 +31,7 @@ using std::vector;
 using std::string;
 using std::cout;
 using std::max;
+using std::upper_bound;
 using boost::shared_ptr;
 using boost::optional;
 using boost::dynamic_pointer_cast;
@@ -44,31 +46,23 @@ TextSubtitleDecoder::TextSubtitleDecoder (shared_ptr<const TextSubtitleContent>
 void
 TextSubtitleDecoder::seek (ContentTime time, bool accurate)
 {
-	/* It's worth back-tracking a little here as decoding is cheap and it's nice if we don't miss
-	   too many subtitles when seeking.
-	*/
-	time -= ContentTime::from_seconds (5);
-	if (time < ContentTime()) {
-		time = ContentTime();
-	}
-
 	Decoder::seek (time, accurate);
 
-	_next = 0;
-	while (_next < _subtitles.size() && ContentTime::from_seconds (_subtitles[_next].from.all_as_seconds ()) < time) {
-		++_next;
-	}
+	/* Start with the first subtitle which is still on screen at `time' or later; everything
+	   before (*_subtitles)[_next] has finished by then.
+	*/
+	_next = upper_bound (_latest_to.begin(), _latest_to.end(), time) - _latest_to.begin();
 }
 
 bool
 TextSubtitleDecoder::pass ()
 {
-	if (_next >= _subtitles.size ()) {
+	if (_next >= _subtitles->size ()) {
 		return true;
 	}
 
-	ContentTimePeriod const p = content_time_period (_subtitles[_next]);
-	subtitle->emit_text (p, _subtitles[_next]);
+	ContentTimePeriod const p = content_time_period ((*_subtitles)[_next]);
+	subtitle->emit_text (p, (*_subtitles)[_next]);
 
 	++_next;
 	return false;
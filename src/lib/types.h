@@ -46,7 +46,7 @@ namespace xmlpp {
  *  with servers.  Intended to be bumped when incompatibilities
  *  are introduced.  v2 uses 64+n
  */
-#define SERVER_LINK_VERSION (64+0)
+#define SERVER_LINK_VERSION (64+1)
 
 /** A film of F seconds at f FPS will be Ff frames;
     Consider some delta FPS d, so if we run the same
@@ -0,0 +1,179 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "worker_pool.h"
+#include <boost/bind.hpp>
+#include <boost/exception/all.hpp>
+#include <algorithm>
+
+using std::max;
+using boost::shared_ptr;
+
+WorkerPool* WorkerPool::_instance = 0;
+
+/** A set of parts passed to run() */
+struct WorkerPool::Batch
+{
+	Batch (int parts_, boost::function<void (int)> function_)
+		: function (function_)
+		, parts (parts_)
+		, next (0)
+		, remaining (parts_)
+	{}
+
+	boost::function<void (int)> function;
+	int const parts;
+
+	boost::mutex mutex;
+	boost::condition finished;
+	/** index of the next part to start */
+	int next;
+	/** number of parts which have not yet finished */
+	int remaining;
+	/** first exception thrown by any part */
+	boost::exception_ptr exception;
+};
+
+WorkerPool::WorkerPool (int threads)
+	: _stop (false)
+{
+	for (int i = 0; i < threads; ++i) {
+		_threads.create_thread (boost::bind (&WorkerPool::thread, this));
+	}
+}
+
+WorkerPool::~WorkerPool ()
+{
+	{
+		boost::mutex::scoped_lock lm (_mutex);
+		_stop = true;
+		_condition.notify_all ();
+	}
+
+	_threads.join_all ();
+}
+
+/** Start a part of a batch, if there are any left, and run it.
+ *  @return false if there were no parts left to start.
+ */
+bool
+WorkerPool::do_part (shared_ptr<Batch> batch)
+{
+	int n;
+	{
+		boost::mutex::scoped_lock lm (batch->mutex);
+		if (batch->next == batch->parts) {
+			return false;
+		}
+		n = batch->next++;
+	}
+
+	try {
+		batch->function (n);
+	} catch (...) {
+		boost::mutex::scoped_lock lm (batch->mutex);
+		if (!batch->exception) {
+			batch->exception = boost::current_exception ();
+		}
+	}
+
+	boost::mutex::scoped_lock lm (batch->mutex);
+	if (--batch->remaining == 0) {
+		batch->finished.notify_all ();
+	}
+
+	return true;
+}
+
+void
+WorkerPool::thread ()
+{
+	while (true) {
+		shared_ptr<Batch> batch;
+
+		{
+			boost::mutex::scoped_lock lm (_mutex);
+			while (!_stop && _batches.empty ()) {
+				_condition.wait (lm);
+			}
+
+			if (_stop) {
+				return;
+			}
+
+			batch = _batches.front ();
+		}
+
+		if (!do_part (batch)) {
+			/* Nothing left to start in this batch, so forget about it */
+			boost::mutex::scoped_lock lm (_mutex);
+			_batches.remove (batch);
+		}
+	}
+}
+
+/** Run some function for each of a number of parts, using the calling
+ *  thread and any idle pool threads, and wait for them all to finish.
+ *  If any part throws an exception the first one will be re-thrown here
+ *  once all parts have finished.
+ *
+ *  @param parts Number of parts.
+ *  @param part Function to call with the index of each part, from 0 to parts - 1;
+ *  it may be called from several threads at once.
+ */
+void
+WorkerPool::run (int parts, boost::function<void (int)> part)
+{
+	shared_ptr<Batch> batch (new Batch (parts, part));
+
+	if (parts > 1 && _threads.size() > 0) {
+		boost::mutex::scoped_lock lm (_mutex);
+		_batches.push_back (batch);
+		_condition.notify_all ();
+	}
+
+	while (do_part (batch)) {}
+
+	{
+		boost::mutex::scoped_lock lm (_mutex);
+		_batches.remove (batch);
+	}
+
+	boost::mutex::scoped_lock lm (batch->mutex);
+	while (batch->remaining > 0) {
+		batch->finished.wait (lm);
+	}
+
+	if (batch->exception) {
+		boost::rethrow_exception (batch->exception);
+	}
+}
+
+WorkerPool *
+WorkerPool::instance ()
+{
+	static boost::mutex instance_mutex;
+	boost::mutex::scoped_lock lm (instance_mutex);
+	if (!_instance) {
+		_instance = new WorkerPool (max (1U, boost::thread::hardware_concurrency ()) - 1);
+	}
+
+	return _instance;
+}
@@ -0,0 +1,69 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DCPOMATIC_WORKER_POOL_H
+#define DCPOMATIC_WORKER_POOL_H
+
+#include <boost/thread.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <list>
+
+/** @class WorkerPool
+ *  @brief A pool of threads which can help to split small jobs (like scaling a
+ *  single image) across CPU cores.
+ *
+ *  A caller of run() does some of the work itself, and any pool threads which
+ *  are not busy help out.  This means that run() always makes progress even if
+ *  all the pool threads are busy with other callers' work.
+ */
+class WorkerPool : public boost::noncopyable
+{
+public:
+	void run (int parts, boost::function<void (int)> part);
+
+	int threads () const {
+		return _threads.size ();
+	}
+
+	static WorkerPool* instance ();
+
+private:
+	explicit WorkerPool (int threads);
+	~WorkerPool ();
+
+	struct Batch;
+
+	void thread ();
+	static bool do_part (boost::shared_ptr<Batch> batch);
+
+	boost::thread_group _threads;
+	boost::mutex _mutex;
+	boost::condition _condition;
+	/** batches which have parts that have not yet been started */
+	std::list<boost::shared_ptr<Batch> > _batches;
+	bool _stop;
+
+	static WorkerPool* _instance;
+};
+
+#endif
@@ -68,6 +68,15 @@ using boost::weak_ptr;
 using boost::dynamic_pointer_cast;
 using dcp::Data;
 
+static void
+ignore_progress (float)
+{
+	/* This is called regularly during copies and digest calculations, so it is a
+	   good place to notice that the Writer is being destroyed.
+	*/
+	boost::this_thread::interruption_point ();
+}
+
 Writer::Writer (shared_ptr<const Film> film, weak_ptr<Job> j)
 	: _film (film)
 	, _job (j)
@@ -95,6 +104,10 @@ Writer::Writer (shared_ptr<const Film> film, weak_ptr<Job> j)
 	_audio_reel = _reels.begin ();
 	_subtitle_reel = _reels.begin ();
 
+	_video_done.resize (_reels.size(), false);
+	_audio_done.resize (_reels.size(), _film->audio_channels() == 0);
+	_finalising.resize (_reels.size(), false);
+
 	/* Check that the signer is OK if we need one */
 	string reason;
 	if (_film->is_signed() && !Config::instance()->signer_chain()->valid(&reason)) {
@@ -106,11 +119,23 @@ void
 Writer::start ()
 {
 	_thread = new boost::thread (boost::bind (&Writer::thread, this));
+
+	/* One thread to finalise reels while we are still encoding; more are added in finish() */
+	_finalise_work.reset (new boost::asio::io_service::work (_finalise_service));
+	_finalise_pool.create_thread (boost::bind (&boost::asio::io_service::run, &_finalise_service));
 }
 
 Writer::~Writer ()
 {
 	terminate_thread (false);
+
+	/* Stop any finalisation that is going on; the threads will notice the
+	   interruption when they next report progress.
+	*/
+	_finalise_work.reset ();
+	_finalise_service.stop ();
+	_finalise_pool.interrupt_all ();
+	_finalise_pool.join_all ();
 }
 
 /** Pass a video frame to the writer for writing to disk at some point.
@@ -251,14 +276,28 @@ Writer::write (shared_ptr<const AudioBuffers> audio)
 		int32_t const reel_space = _audio_reel->period().duration().frames_floor(_film->audio_frame_rate()) - _audio_reel->total_written_audio_frames();
 
 		if (remaining <= reel_space) {
-			/* Easy case: we can write all the audio to this reel */
-			_audio_reel->write (audio);
+			/* Easy case: we can write all the (remaining) audio to this reel */
+			if (offset == 0) {
+				_audio_reel->write (audio);
+			} else {
+				shared_ptr<AudioBuffers> part (new AudioBuffers (audio->channels(), remaining));
+				part->copy_from (audio.get(), remaining, offset, 0);
+				_audio_reel->write (part);
+			}
 			offset += remaining;
+			if (remaining == reel_space) {
+				/* This reel is now full, and may be finalised at any time, so we must not touch it again */
+				reel_audio_done (_audio_reel - _reels.begin());
+				++_audio_reel;
+			}
 		} else {
 			/* Write the part we can */
-			shared_ptr<AudioBuffers> part (new AudioBuffers (audio->channels(), reel_space));
-			part->copy_from (audio.get(), reel_space, offset, 0);
-			_audio_reel->write (part);
+			if (reel_space > 0) {
+				shared_ptr<AudioBuffers> part (new AudioBuffers (audio->channels(), reel_space));
+				part->copy_from (audio.get(), reel_space, offset, 0);
+				_audio_reel->write (part);
+			}
+			reel_audio_done (_audio_reel - _reels.begin());
 			++_audio_reel;
 			offset += reel_space;
 		}
@@ -308,6 +347,9 @@ try
 
 		while (true) {
 
+			/* Stop if finalising an earlier reel has failed */
+			rethrow ();
+
 			if (_finish || _queued_full_in_memory > _maximum_frames_in_memory || have_sequenced_image_at_queue_head ()) {
 				/* We've got something to do: go and do it */
 				break;
@@ -376,6 +418,11 @@ try
 				break;
 			}
 
+			if (qi.eyes != EYES_LEFT && qi.frame == (reel.period().duration().frames_round(_film->video_frame_rate()) - 1)) {
+				/* That was the last frame in this reel */
+				reel_video_done (qi.reel);
+			}
+
 			lock.lock ();
 		}
 
@@ -461,10 +508,26 @@ Writer::finish ()
 
 	LOG_GENERAL_NC ("Finishing ReelWriters");
 
-	BOOST_FOREACH (ReelWriter& i, _reels) {
-		i.finish ();
+	shared_ptr<Job> job = _job.lock ();
+	job->sub (_("Computing digests"));
+
+	/* Finish any reels that were not finished as soon as they were
+	   complete, and wait for all digests to be calculated.
+	*/
+	for (size_t i = 0; i < _reels.size(); ++i) {
+		maybe_finalise_reel (i, true, true);
 	}
 
+	int const threads = max (1, Config::instance()->master_encoding_threads ());
+	for (int i = 1; i < threads; ++i) {
+		_finalise_pool.create_thread (boost::bind (&boost::asio::io_service::run, &_finalise_service));
+	}
+
+	_finalise_work.reset ();
+	_finalise_pool.join_all ();
+	_finalise_service.stop ();
+	rethrow ();
+
 	LOG_GENERAL_NC ("Writing XML");
 
 	dcp::DCP dcp (_film->dir (_film->dcp_name()));
@@ -478,31 +541,6 @@ Writer::finish ()
 
 	dcp.add (cpl);
 
-	/* Calculate digests for each reel in parallel */
-
-	shared_ptr<Job> job = _job.lock ();
-	job->sub (_("Computing digests"));
-
-	boost::asio::io_service service;
-	boost::thread_group pool;
-
-	shared_ptr<boost::asio::io_service::work> work (new boost::asio::io_service::work (service));
-
-	int const threads = max (1, Config::instance()->master_encoding_threads ());
-
-	for (int i = 0; i < threads; ++i) {
-		pool.create_thread (boost::bind (&boost::asio::io_service::run, &service));
-	}
-
-	BOOST_FOREACH (ReelWriter& i, _reels) {
-		boost::function<void (float)> set_progress = boost::bind (&Writer::set_digest_progress, this, job.get(), _1);
-		service.post (boost::bind (&ReelWriter::calculate_digests, &i, set_progress));
-	}
-
-	work.reset ();
-	pool.join_all ();
-	service.stop ();
-
 	/* Add reels to CPL */
 
 	BOOST_FOREACH (ReelWriter& i, _reels) {
@@ -707,9 +745,78 @@ Writer::video_reel (int frame) const
 	return i;
 }
 
+/** Note that all the video for a reel has been written.  Called from the writer thread */
+void
+Writer::reel_video_done (size_t reel)
+{
+	{
+		boost::mutex::scoped_lock lm (_finalise_mutex);
+		_video_done[reel] = true;
+	}
+	maybe_finalise_reel (reel, false, false);
+}
+
+/** Note that all the audio for a reel has been written.  Called from the thread which calls write() for audio */
+void
+Writer::reel_audio_done (size_t reel)
+{
+	{
+		boost::mutex::scoped_lock lm (_finalise_mutex);
+		_audio_done[reel] = true;
+	}
+	maybe_finalise_reel (reel, false, false);
+}
+
+/** Start finalising a reel if nothing more is going to be written to it
+ *  and it is not already being finalised.
+ *  @param force true to finalise it even if we have not seen all its data.
+ *  @param report_progress true to report digest progress to our Job.
+ */
+void
+Writer::maybe_finalise_reel (size_t reel, bool force, bool report_progress)
+{
+	boost::mutex::scoped_lock lm (_finalise_mutex);
+	if (_finalising[reel] || (!force && (!_video_done[reel] || !_audio_done[reel]))) {
+		return;
+	}
+
+	_finalising[reel] = true;
+	_finalise_service.post (boost::bind (&Writer::finalise_reel, this, reel, report_progress));
+}
+
+/** Run on one of the _finalise_pool threads */
+void
+Writer::finalise_reel (size_t reel, bool report_progress)
+try
+{
+	LOG_GENERAL ("Finalising reel %1", reel);
+
+	shared_ptr<Job> job = _job.lock ();
+	DCPOMATIC_ASSERT (job);
+
+	boost::function<void (float)> set_progress;
+	if (report_progress) {
+		set_progress = boost::bind (&Writer::set_digest_progress, this, job.get(), _1);
+	} else {
+		/* The Job is busy reporting encoding progress, so keep quiet */
+		set_progress = boost::bind (&ignore_progress, _1);
+	}
+
+	_reels[reel].finish (set_progress);
+	_reels[reel].calculate_digests (set_progress);
+}
+catch (...)
+{
+	store_current ();
+	/* Wake the writer thread so that it notices the problem */
+	_empty_condition.notify_all ();
+}
+
 void
 Writer::set_digest_progress (Job* job, float progress)
 {
+	boost::this_thread::interruption_point ();
+
 	/* I believe this is thread-safe */
 	_digest_progresses[boost::this_thread::get_id()] = progress;
 
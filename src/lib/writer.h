@@ -29,6 +29,7 @@
 #include <boost/weak_ptr.hpp>
 #include <boost/thread.hpp>
 #include <boost/thread/condition.hpp>
+#include <boost/asio.hpp>
 #include <list>
 
 namespace dcp {
@@ -118,6 +119,10 @@ private:
 	size_t video_reel (int frame) const;
 	void set_digest_progress (Job* job, float progress);
 	void write_cover_sheet ();
+	void reel_video_done (size_t reel);
+	void reel_audio_done (size_t reel);
+	void maybe_finalise_reel (size_t reel, bool force, bool report_progress);
+	void finalise_reel (size_t reel, bool report_progress);
 
 	/** our Film */
 	boost::shared_ptr<const Film> _film;
@@ -155,6 +160,21 @@ private:
 	*/
 	int _pushed_to_disk;
 
+	/** mutex for _video_done, _audio_done and _finalising */
+	boost::mutex _finalise_mutex;
+	/** true for each reel whose video has all been written */
+	std::vector<bool> _video_done;
+	/** true for each reel whose audio has all been written */
+	std::vector<bool> _audio_done;
+	/** true for each reel which has been passed to the finalise threads */
+	std::vector<bool> _finalising;
+	/** service to run ReelWriter::finish and digest calculations for reels
+	 *  as soon as they are complete.
+	 */
+	boost::asio::io_service _finalise_service;
+	boost::shared_ptr<boost::asio::io_service::work> _finalise_work;
+	boost::thread_group _finalise_pool;
+
 	boost::mutex _digest_progresses_mutex;
 	std::map<boost::thread::id, float> _digest_progresses;
 
@@ -0,0 +1,167 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/** @file  src/lib/xyz_converter.cc
+ *  @brief Conversion of RGB48LE pixels to 12-bit XYZ using a particular colour conversion.
+ *
+ *  dcp::rgb_to_xyz looks up each pixel in two double-precision LUTs, multiplies
+ *  by a matrix, and makes three calls to lrint.  Here the output LUT is rounded
+ *  to 12-bit integers in advance, the rounding to a LUT index is done without
+ *  calling lrint, and the clamping is done on integers; this lets the compiler
+ *  vectorise the loop (using gathers for the table lookups with AVX2).  The
+ *  arithmetic is the same, in the same order, so the results are identical.
+ */
+
+#include "xyz_converter.h"
+#include "colour_conversion.h"
+#include "dcpomatic_assert.h"
+#include <dcp/colour_conversion.h>
+#include <dcp/rgb_xyz.h>
+#include <dcp/transfer_function.h>
+#include <cmath>
+
+using std::list;
+using std::pair;
+using std::make_pair;
+using std::string;
+using boost::shared_ptr;
+
+boost::mutex XYZConverter::_cache_mutex;
+list<pair<string, shared_ptr<const XYZConverter> > > XYZConverter::_cache;
+int const XYZConverter::_max_cached = 4;
+
+/** @return v rounded to the nearest integer (with ties to even) as lrint would,
+ *  for |v| < 2^31.  Adding and then subtracting 2^52 + 2^51 leaves no bits for
+ *  the fractional part, so the FPU does the rounding for us.
+ */
+static DCPOMATIC_KERNEL_INLINE int
+round_to_int (double v)
+{
+	return int ((v + 6755399441055744.0) - 6755399441055744.0);
+}
+
+static DCPOMATIC_KERNEL_INLINE int
+clamp_16 (int v)
+{
+	return v < 0 ? 0 : (v > 65535 ? 65535 : v);
+}
+
+static DCPOMATIC_KERNEL_INLINE void
+rgb48le_to_xyz_body (
+	uint16_t const * __restrict p, int width, int* __restrict x, int* __restrict y, int* __restrict z,
+	double const * __restrict lut_in, double const * __restrict matrix, int const * __restrict lut_out, int* clamped
+	)
+{
+	double const m0 = matrix[0];
+	double const m1 = matrix[1];
+	double const m2 = matrix[2];
+	double const m3 = matrix[3];
+	double const m4 = matrix[4];
+	double const m5 = matrix[5];
+	double const m6 = matrix[6];
+	double const m7 = matrix[7];
+	double const m8 = matrix[8];
+
+	int n = 0;
+	for (int i = 0; i < width; ++i) {
+		/* In gamma LUT (converting 16-bit to 12-bit) */
+		double const r = lut_in[p[i * 3] >> 4];
+		double const g = lut_in[p[i * 3 + 1] >> 4];
+		double const b = lut_in[p[i * 3 + 2] >> 4];
+
+		/* RGB to XYZ, Bradford transform and DCI companding */
+		double const dx = r * m0 + g * m1 + b * m2;
+		double const dy = r * m3 + g * m4 + b * m5;
+		double const dz = r * m6 + g * m7 + b * m8;
+
+		n += (dx < 0) | (dy < 0) | (dz < 0) | (dx > 65535) | (dy > 65535) | (dz > 65535);
+
+		/* Out gamma LUT; rounding then clamping gives the same as clamping then rounding,
+		   as the limits are integers.
+		*/
+		x[i] = lut_out[clamp_16 (round_to_int (dx))];
+		y[i] = lut_out[clamp_16 (round_to_int (dy))];
+		z[i] = lut_out[clamp_16 (round_to_int (dz))];
+	}
+
+	*clamped = n;
+}
+
+DCPOMATIC_KERNEL (
+	rgb48le_to_xyz,
+	(uint16_t const * p, int width, int* x, int* y, int* z, double const * lut_in, double const * matrix, int const * lut_out, int* clamped),
+	(p, width, x, y, z, lut_in, matrix, lut_out, clamped)
+	)
+
+XYZConverter::XYZConverter (dcp::ColourConversion const & conversion)
+	: _lut_in (4096)
+	, _lut_out (65536)
+{
+	double const * lut_in = conversion.in()->lut (12, false);
+	std::copy (lut_in, lut_in + 4096, _lut_in.begin ());
+
+	dcp::combined_rgb_to_xyz (conversion, _matrix);
+
+	double const * lut_out = conversion.out()->lut (16, true);
+	for (int i = 0; i < 65536; ++i) {
+		_lut_out[i] = lrint (lut_out[i] * 4095);
+	}
+}
+
+/** Convert a row of pixels.
+ *  @param rgb RGB48LE pixels.
+ *  @param width Number of pixels.
+ *  @param x, y, z Arrays to write the 12-bit results to, each with space for width values.
+ *  @param level Instruction set to use.
+ *  @return Number of pixels whose XYZ values had to be clamped.
+ */
+int
+XYZConverter::convert_row (uint16_t const * rgb, int width, int* x, int* y, int* z, SIMDLevel level) const
+{
+	int clamped = 0;
+	DCPOMATIC_KERNEL_CALL (rgb48le_to_xyz, level, (rgb, width, x, y, z, &_lut_in[0], _matrix, &_lut_out[0], &clamped));
+	return clamped;
+}
+
+/** @return A converter for a conversion, made now or earlier by another caller */
+shared_ptr<const XYZConverter>
+XYZConverter::get (ColourConversion const & conversion)
+{
+	string const id = conversion.identifier ();
+
+	boost::mutex::scoped_lock lm (_cache_mutex);
+
+	for (list<pair<string, shared_ptr<const XYZConverter> > >::iterator i = _cache.begin(); i != _cache.end(); ++i) {
+		if (i->first == id) {
+			pair<string, shared_ptr<const XYZConverter> > p = *i;
+			_cache.erase (i);
+			_cache.push_front (p);
+			return p.second;
+		}
+	}
+
+	shared_ptr<const XYZConverter> c (new XYZConverter (conversion));
+	_cache.push_front (make_pair (id, c));
+	while (int (_cache.size()) > _max_cached) {
+		_cache.pop_back ();
+	}
+
+	return c;
+}
@@ -0,0 +1,70 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DCPOMATIC_XYZ_CONVERTER_H
+#define DCPOMATIC_XYZ_CONVERTER_H
+
+#include "simd.h"
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/noncopyable.hpp>
+#include <list>
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+namespace dcp {
+	class ColourConversion;
+}
+
+class ColourConversion;
+
+/** @class XYZConverter
+ *  @brief Conversion of RGB48LE pixels to 12-bit XYZ using a particular colour conversion.
+ *
+ *  The results are the same as those from dcp::rgb_to_xyz, but the tables that are
+ *  needed are worked out once (and then shared via get()) and the inner loop can be
+ *  vectorised.
+ */
+class XYZConverter : public boost::noncopyable
+{
+public:
+	explicit XYZConverter (dcp::ColourConversion const & conversion);
+
+	int convert_row (uint16_t const * rgb, int width, int* x, int* y, int* z, SIMDLevel level) const;
+
+	static boost::shared_ptr<const XYZConverter> get (ColourConversion const & conversion);
+
+private:
+	/** linear value for each 12-bit input sample */
+	std::vector<double> _lut_in;
+	/** combined RGB to XYZ matrix, scaled so that its results are in the range 0-65535 */
+	double _matrix[9];
+	/** 12-bit output value for each 16-bit linear XYZ sample */
+	std::vector<int> _lut_out;
+
+	static boost::mutex _cache_mutex;
+	/** converters keyed by ColourConversion identifier, most recently used first */
+	static std::list<std::pair<std::string, boost::shared_ptr<const XYZConverter> > > _cache;
+	/** maximum number of converters to keep in _cache */
+	static int const _max_cached;
+};
+
+#endif
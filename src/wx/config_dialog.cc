@@ -548,6 +548,10 @@ private:
 			table->Add (s, 1);
 		}
 
+		add_label_to_sizer (table, _panel, _("Threads to use for scaling each image"), true);
+		_scale_threads = new wxSpinCtrl (_panel);
+		table->Add (_scale_threads, 1);
+
 		{
 			add_label_to_sizer (table, _panel, _("Default audio delay"), true);
 			wxBoxSizer* s = new wxBoxSizer (wxHORIZONTAL);
@@ -1653,6 +1657,7 @@ public:
 	AdvancedPage (wxSize panel_size, int border)
 		: StockPage (Kind_Advanced, panel_size, border)
 		, _maximum_j2k_bandwidth (0)
+		, _scale_threads (0)
 		, _allow_any_dcp_frame_rate (0)
 		, _only_servers_encode (0)
 		, _log_general (0)
@@ -1758,6 +1763,8 @@ private:
 
 		_maximum_j2k_bandwidth->SetRange (1, 1000);
 		_maximum_j2k_bandwidth->Bind (wxEVT_SPINCTRL, boost::bind (&AdvancedPage::maximum_j2k_bandwidth_changed, this));
+		_scale_threads->SetRange (1, 16);
+		_scale_threads->Bind (wxEVT_SPINCTRL, boost::bind (&AdvancedPage::scale_threads_changed, this));
 		_allow_any_dcp_frame_rate->Bind (wxEVT_CHECKBOX, boost::bind (&AdvancedPage::allow_any_dcp_frame_rate_changed, this));
 		_only_servers_encode->Bind (wxEVT_CHECKBOX, boost::bind (&AdvancedPage::only_servers_encode_changed, this));
 		_dcp_metadata_filename_format->Changed.connect (boost::bind (&AdvancedPage::dcp_metadata_filename_format_changed, this));
@@ -1779,6 +1786,7 @@ private:
 		Config* config = Config::instance ();
 
 		checked_set (_maximum_j2k_bandwidth, config->maximum_j2k_bandwidth() / 1000000);
+		checked_set (_scale_threads, config->scale_threads ());
 		checked_set (_allow_any_dcp_frame_rate, config->allow_any_dcp_frame_rate ());
 		checked_set (_only_servers_encode, config->only_servers_encode ());
 		checked_set (_log_general, config->log_types() & LogEntry::TYPE_GENERAL);
@@ -1798,6 +1806,11 @@ private:
 		Config::instance()->set_maximum_j2k_bandwidth (_maximum_j2k_bandwidth->GetValue() * 1000000);
 	}
 
+	void scale_threads_changed ()
+	{
+		Config::instance()->set_scale_threads (_scale_threads->GetValue ());
+	}
+
 	void allow_any_dcp_frame_rate_changed ()
 	{
 		Config::instance()->set_allow_any_dcp_frame_rate (_allow_any_dcp_frame_rate->GetValue ());
@@ -1853,6 +1866,7 @@ private:
 #endif
 
 	wxSpinCtrl* _maximum_j2k_bandwidth;
+	wxSpinCtrl* _scale_threads;
 	wxCheckBox* _allow_any_dcp_frame_rate;
 	wxCheckBox* _only_servers_encode;
 	NameFormatEditor* _dcp_metadata_filename_format;
@@ -0,0 +1,174 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/** @file  test/active_subtitles_test.cc
+ *  @brief Test ActiveSubtitles.
+ *  @ingroup specific
+ */
+
+#include "lib/active_subtitles.h"
+#include "lib/piece.h"
+#include "lib/text_subtitle_content.h"
+#include "lib/subtitle_content.h"
+#include "lib/film.h"
+#include "test.h"
+#include <dcp/subtitle_string.h>
+#include <boost/test/unit_test.hpp>
+#include <boost/foreach.hpp>
+
+using std::list;
+using std::string;
+using boost::shared_ptr;
+
+static PlayerSubtitles
+subs (string text)
+{
+	PlayerSubtitles ps;
+	ps.text.push_back (
+		SubtitleString (
+			dcp::SubtitleString (
+				boost::optional<string> (),
+				false,
+				false,
+				false,
+				dcp::Colour (255, 255, 255),
+				42,
+				1,
+				dcp::Time (),
+				dcp::Time (),
+				0,
+				dcp::HALIGN_CENTER,
+				0,
+				dcp::VALIGN_CENTER,
+				dcp::DIRECTION_LTR,
+				text,
+				dcp::NONE,
+				dcp::Colour (0, 0, 0),
+				dcp::Time (),
+				dcp::Time ()
+				)
+			)
+		);
+	return ps;
+}
+
+/** @return the texts of the subtitles that ActiveSubtitles says should be burnt in at a time, joined together */
+static string
+burnt (ActiveSubtitles const & active, double seconds)
+{
+	string s;
+	BOOST_FOREACH (PlayerSubtitles i, active.get_burnt (DCPTime::from_seconds (seconds), false)) {
+		BOOST_FOREACH (SubtitleString j, i.text) {
+			s += j.text ();
+		}
+	}
+	return s;
+}
+
+static shared_ptr<Piece>
+subtitle_piece (shared_ptr<Film> film)
+{
+	shared_ptr<TextSubtitleContent> content (new TextSubtitleContent (film, "test/data/subrip.srt"));
+	content->subtitle->set_use (true);
+	content->subtitle->set_burn (true);
+	return shared_ptr<Piece> (new Piece (content, shared_ptr<Decoder> (), FrameRateChange (24, 24)));
+}
+
+/** Overlapping subtitles, some of which are zero-length */
+BOOST_AUTO_TEST_CASE (active_subtitles_test1)
+{
+	shared_ptr<Film> film = new_test_film ("active_subtitles_test1");
+	shared_ptr<Piece> piece = subtitle_piece (film);
+
+	ActiveSubtitles active;
+	active.add_from (piece, subs ("A"), DCPTime::from_seconds (0));
+	active.add_to (piece, DCPTime::from_seconds (10));
+	active.add_from (piece, subs ("B"), DCPTime::from_seconds (5));
+	active.add_to (piece, DCPTime::from_seconds (15));
+	active.add_from (piece, subs ("Z"), DCPTime::from_seconds (7));
+	active.add_to (piece, DCPTime::from_seconds (7));
+	active.add_from (piece, subs ("C"), DCPTime::from_seconds (12));
+	active.add_to (piece, DCPTime::from_seconds (20));
+
+	BOOST_CHECK_EQUAL (burnt (active, 0), "A");
+	BOOST_CHECK_EQUAL (burnt (active, 5), "AB");
+	BOOST_CHECK_EQUAL (burnt (active, 7), "AB");
+	BOOST_CHECK_EQUAL (burnt (active, 10), "B");
+	BOOST_CHECK_EQUAL (burnt (active, 12), "BC");
+	BOOST_CHECK_EQUAL (burnt (active, 15), "C");
+	BOOST_CHECK_EQUAL (burnt (active, 20), "");
+
+	/* A and Z finish before 12 so they should go, but the others should not */
+	active.clear_before (DCPTime::from_seconds (12));
+	BOOST_CHECK (active.have (piece));
+	BOOST_CHECK_EQUAL (burnt (active, 12), "BC");
+	BOOST_CHECK_EQUAL (burnt (active, 15), "C");
+
+	/* Subtitles which finish exactly at the clear time stay */
+	active.clear_before (DCPTime::from_seconds (20));
+	BOOST_CHECK (active.have (piece));
+	active.clear_before (DCPTime::from_seconds (21));
+	BOOST_CHECK (!active.have (piece));
+	BOOST_CHECK_EQUAL (burnt (active, 15), "");
+}
+
+/** A subtitle with no to time yet, and add_to() changing the to time of a subtitle */
+BOOST_AUTO_TEST_CASE (active_subtitles_test2)
+{
+	shared_ptr<Film> film = new_test_film ("active_subtitles_test2");
+	shared_ptr<Piece> piece = subtitle_piece (film);
+
+	ActiveSubtitles active;
+	active.add_from (piece, subs ("A"), DCPTime::from_seconds (1));
+	BOOST_CHECK_EQUAL (burnt (active, 0), "");
+	BOOST_CHECK_EQUAL (burnt (active, 1), "A");
+	BOOST_CHECK_EQUAL (burnt (active, 1000), "A");
+
+	/* Subtitles with no to time are never cleared */
+	active.clear_before (DCPTime::from_seconds (1000));
+	BOOST_CHECK_EQUAL (burnt (active, 1000), "A");
+
+	active.add_to (piece, DCPTime::from_seconds (10));
+	BOOST_CHECK_EQUAL (burnt (active, 9), "A");
+	BOOST_CHECK_EQUAL (burnt (active, 10), "");
+
+	active.add_to (piece, DCPTime::from_seconds (5));
+	BOOST_CHECK_EQUAL (burnt (active, 5), "");
+	active.clear_before (DCPTime::from_seconds (6));
+	BOOST_CHECK (!active.have (piece));
+}
+
+/** Many subtitles, each on screen at the same time as its neighbours */
+BOOST_AUTO_TEST_CASE (active_subtitles_test3)
+{
+	shared_ptr<Film> film = new_test_film ("active_subtitles_test3");
+	shared_ptr<Piece> piece = subtitle_piece (film);
+
+	ActiveSubtitles active;
+	for (int i = 0; i < 5000; ++i) {
+		active.add_from (piece, subs (i % 2 ? "o" : "e"), DCPTime::from_seconds (i));
+		active.add_to (piece, DCPTime::from_seconds (i + 2));
+	}
+
+	for (int i = 1; i < 5000; ++i) {
+		BOOST_REQUIRE_EQUAL (burnt (active, i), i % 2 ? "eo" : "oe");
+		active.clear_before (DCPTime::from_seconds (i));
+	}
+}
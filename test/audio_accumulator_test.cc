@@ -0,0 +1,107 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/** @file  test/audio_accumulator_test.cc
+ *  @brief Test AudioAccumulator.
+ *  @ingroup selfcontained
+ */
+
+#include "lib/audio_accumulator.h"
+#include "lib/audio_buffers.h"
+#include <boost/test/unit_test.hpp>
+#include <boost/foreach.hpp>
+
+using std::list;
+using boost::shared_ptr;
+
+/** Push lots of small buffers in and check that we get fewer, bigger ones
+ *  out, with the same data in them.
+ */
+BOOST_AUTO_TEST_CASE (audio_accumulator_test1)
+{
+	int const channels = 16;
+	int const block = 48000;
+	AudioAccumulator acc (channels, block);
+
+	int pushes = 0;
+	int writes = 0;
+	int in_value = 0;
+	int out_value = 0;
+	int out_frames = 0;
+
+	for (int i = 0; i < 2000; ++i) {
+		/* 2000 pushes of between 100 and 199 frames */
+		int const frames = 100 + (i % 100);
+		shared_ptr<AudioBuffers> in (new AudioBuffers (channels, frames));
+		for (int j = 0; j < frames; ++j) {
+			for (int k = 0; k < channels; ++k) {
+				in->data(k)[j] = in_value + k;
+			}
+			++in_value;
+		}
+
+		++pushes;
+		BOOST_FOREACH (shared_ptr<const AudioBuffers> j, acc.push (in)) {
+			++writes;
+			BOOST_REQUIRE_EQUAL (j->frames(), block);
+			for (int k = 0; k < j->frames(); ++k) {
+				for (int l = 0; l < channels; ++l) {
+					BOOST_REQUIRE_EQUAL (j->data(l)[k], out_value + l);
+				}
+				++out_value;
+			}
+			out_frames += j->frames ();
+		}
+	}
+
+	shared_ptr<const AudioBuffers> rest = acc.flush ();
+	BOOST_REQUIRE (rest);
+	++writes;
+	for (int k = 0; k < rest->frames(); ++k) {
+		for (int l = 0; l < channels; ++l) {
+			BOOST_REQUIRE_EQUAL (rest->data(l)[k], out_value + l);
+		}
+		++out_value;
+	}
+	out_frames += rest->frames ();
+
+	/* Everything should come out, in far fewer writes than there were pushes */
+	BOOST_CHECK_EQUAL (out_frames, in_value);
+	BOOST_CHECK_EQUAL (pushes, 2000);
+	BOOST_CHECK_EQUAL (writes, 7);
+
+	/* Nothing left */
+	BOOST_CHECK (!acc.flush ());
+}
+
+/** A push bigger than a block should give several blocks at once */
+BOOST_AUTO_TEST_CASE (audio_accumulator_test2)
+{
+	AudioAccumulator acc (2, 100);
+	shared_ptr<AudioBuffers> in (new AudioBuffers (2, 350));
+	in->make_silent ();
+
+	list<shared_ptr<const AudioBuffers> > out = acc.push (in);
+	BOOST_CHECK_EQUAL (out.size(), 3);
+
+	shared_ptr<const AudioBuffers> rest = acc.flush ();
+	BOOST_REQUIRE (rest);
+	BOOST_CHECK_EQUAL (rest->frames(), 50);
+}
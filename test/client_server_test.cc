@@ -98,7 +98,7 @@ BOOST_AUTO_TEST_CASE (client_server_test_rgb)
 			)
 		);
 
-	pvf->set_subtitle (PositionImage (sub_image, Position<int> (50, 60)));
+	pvf->set_subtitles (list<PositionImage> (1, PositionImage (sub_image, Position<int> (50, 60))));
 
 	shared_ptr<DCPVideo> frame (
 		new DCPVideo (
@@ -180,7 +180,7 @@ BOOST_AUTO_TEST_CASE (client_server_test_yuv)
 			)
 		);
 
-	pvf->set_subtitle (PositionImage (sub_image, Position<int> (50, 60)));
+	pvf->set_subtitles (list<PositionImage> (1, PositionImage (sub_image, Position<int> (50, 60))));
 
 	shared_ptr<DCPVideo> frame (
 		new DCPVideo (
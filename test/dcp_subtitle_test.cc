@@ -34,11 +34,15 @@
 #include "lib/subtitle_content.h"
 #include "lib/content_subtitle.h"
 #include "lib/subtitle_decoder.h"
+#include "lib/subtitle_file_cache.h"
 #include "test.h"
+#include <boost/filesystem.hpp>
 #include <iostream>
+#include <fstream>
 
 using std::cout;
 using std::list;
+using std::ofstream;
 using boost::shared_ptr;
 using boost::optional;
 
@@ -150,3 +154,35 @@ BOOST_AUTO_TEST_CASE (dcp_subtitle_test3)
 		}
 	}
 }
+
+/** Check that decoders for the same subtitle file share one parse of it, until the file changes */
+BOOST_AUTO_TEST_CASE (dcp_subtitle_cache_test)
+{
+	shared_ptr<Film> film = new_test_film ("dcp_subtitle_cache_test");
+	boost::filesystem::path const xml = "build/test/dcp_subtitle_cache_test.xml";
+	boost::filesystem::remove (xml);
+	boost::filesystem::copy_file ("test/data/dcp_sub.xml", xml);
+	shared_ptr<DCPSubtitleContent> content (new DCPSubtitleContent (film, xml));
+
+	SubtitleFileCache* cache = SubtitleFileCache::instance ();
+
+	int const hits = cache->hits ();
+	shared_ptr<DCPSubtitleDecoder> a (new DCPSubtitleDecoder (content, film->log()));
+	BOOST_CHECK_EQUAL (cache->hits(), hits);
+	shared_ptr<DCPSubtitleDecoder> b (new DCPSubtitleDecoder (content, film->log()));
+	BOOST_CHECK_EQUAL (cache->hits(), hits + 1);
+
+	/* Changing the file means it must be read again */
+	{
+		ofstream f (xml.string().c_str(), std::ios::app);
+		f << "\n";
+	}
+
+	shared_ptr<DCPSubtitleDecoder> c (new DCPSubtitleDecoder (content, film->log()));
+	BOOST_CHECK_EQUAL (cache->hits(), hits + 1);
+
+	c->subtitle->TextStart.connect (bind (store, _1));
+	stored = optional<ContentTextSubtitle> ();
+	while (!c->pass() && !stored) {}
+	BOOST_CHECK (stored);
+}
@@ -0,0 +1,106 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/** @file  test/fused_xyz_test.cc
+ *  @brief Check that fused_rgb_to_xyz gives the same results as doing each step separately.
+ *  @ingroup selfcontained
+ */
+
+#include "lib/fused_xyz.h"
+#include "lib/image.h"
+#include "lib/colour_conversion.h"
+#include <dcp/openjpeg_image.h>
+#include <dcp/rgb_xyz.h>
+#include <dcp/colour_conversion.h>
+#include <boost/test/unit_test.hpp>
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <cstdlib>
+
+using std::list;
+using boost::shared_ptr;
+using boost::optional;
+
+static void
+note (dcp::NoteType, std::string)
+{
+
+}
+
+static shared_ptr<Image>
+random_image (AVPixelFormat format, dcp::Size size)
+{
+	shared_ptr<Image> image (new Image (format, size, true));
+	for (int y = 0; y < size.height; ++y) {
+		uint8_t* p = image->data()[0] + y * image->stride()[0];
+		for (int x = 0; x < image->line_size()[0]; ++x) {
+			*p++ = rand() & 0xff;
+		}
+	}
+	return image;
+}
+
+static void
+check (list<PositionImage> subtitles, optional<double> fade)
+{
+	dcp::Size const size (1998, 1080);
+	shared_ptr<Image> source = random_image (AV_PIX_FMT_RGB48LE, size);
+	dcp::ColourConversion const conversion = dcp::ColourConversion::rec709_to_xyz ();
+
+	shared_ptr<Image> separate (new Image (*source));
+	BOOST_FOREACH (PositionImage const & i, subtitles) {
+		separate->alpha_blend (i.image, i.position);
+	}
+	if (fade) {
+		separate->fade (fade.get ());
+	}
+	shared_ptr<dcp::OpenJPEGImage> ref = dcp::rgb_to_xyz (separate->data()[0], size, separate->stride()[0], conversion, boost::bind (&note, _1, _2));
+
+	shared_ptr<Image> fused (new Image (*source));
+	shared_ptr<dcp::OpenJPEGImage> xyz = fused_rgb_to_xyz (fused, subtitles, fade, conversion, boost::bind (&note, _1, _2));
+
+	for (int c = 0; c < 3; ++c) {
+		for (int i = 0; i < size.width * size.height; ++i) {
+			BOOST_REQUIRE_EQUAL (xyz->data(c)[i], ref->data(c)[i]);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE (fused_xyz_test)
+{
+	/* Just the colour conversion */
+	check (list<PositionImage> (), optional<double> ());
+
+	/* Fade */
+	check (list<PositionImage> (), 0.37);
+
+	/* Subtitle which hangs off the top left and another which hangs off the bottom right */
+	PositionImage const top_left (random_image (AV_PIX_FMT_RGBA, dcp::Size (400, 200)), Position<int> (-33, -17));
+	PositionImage const bottom_right (random_image (AV_PIX_FMT_RGBA, dcp::Size (400, 200)), Position<int> (1800, 1000));
+	check (list<PositionImage> (1, top_left), optional<double> ());
+	check (list<PositionImage> (1, bottom_right), 0.81);
+
+	/* Both at once, and two which overlap */
+	list<PositionImage> subtitles;
+	subtitles.push_back (top_left);
+	subtitles.push_back (bottom_right);
+	subtitles.push_back (PositionImage (random_image (AV_PIX_FMT_RGBA, dcp::Size (300, 100)), Position<int> (200, 120)));
+	check (subtitles, 0.5);
+}
@@ -0,0 +1,113 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/** @file  test/image_buffer_pool_test.cc
+ *  @brief Test ImageBufferPool.
+ *  @ingroup selfcontained
+ */
+
+#include "lib/image_buffer_pool.h"
+#include "lib/image.h"
+#include <boost/test/unit_test.hpp>
+
+using boost::shared_ptr;
+
+BOOST_AUTO_TEST_CASE (image_buffer_pool_size_class_test)
+{
+	BOOST_CHECK_EQUAL (ImageBufferPool::size_class (1), 4096);
+	BOOST_CHECK_EQUAL (ImageBufferPool::size_class (4096), 4096);
+	BOOST_CHECK_EQUAL (ImageBufferPool::size_class (4097), 8192);
+
+	for (size_t s = 1; s < 256 * 1024 * 1024; s = s * 3 + 7) {
+		size_t const c = ImageBufferPool::size_class (s);
+		BOOST_CHECK (c >= s);
+		/* No more than 1/8 wasted, except where we are using the minimum granularity */
+		BOOST_CHECK ((c - s) < 4096 || (c - s) * 8 <= s);
+		BOOST_CHECK_EQUAL (ImageBufferPool::size_class (c), c);
+	}
+}
+
+/** Check that buffers are re-used and that the limits are obeyed */
+BOOST_AUTO_TEST_CASE (image_buffer_pool_test1)
+{
+	ImageBufferPool* pool = ImageBufferPool::instance ();
+	pool->clear ();
+
+	ImageBufferPool::Statistics const start = pool->statistics ();
+	BOOST_CHECK_EQUAL (start.idle_buffers, 0);
+	BOOST_CHECK_EQUAL (start.idle_bytes, 0);
+
+	/* A size which no Image in the other tests will be using */
+	size_t const size = 3 * 1024 * 1024 + 17;
+
+	uint8_t* a = pool->get (size);
+	uint8_t* b = pool->get (size);
+	BOOST_CHECK (a != b);
+	pool->put (a, size);
+
+	/* Something in the same size class should get a back */
+	uint8_t* c = pool->get (size + 1);
+	BOOST_CHECK (c == a);
+
+	ImageBufferPool::Statistics s = pool->statistics ();
+	BOOST_CHECK_EQUAL (s.allocations - start.allocations, 2);
+	BOOST_CHECK_EQUAL (s.reuses - start.reuses, 1);
+	BOOST_CHECK_EQUAL (s.idle_buffers, 0);
+
+	pool->put (b, size);
+	pool->put (c, size);
+	s = pool->statistics ();
+	BOOST_CHECK_EQUAL (s.idle_buffers, 2);
+	BOOST_CHECK_EQUAL (s.idle_bytes, int64_t (ImageBufferPool::size_class (size) * 2));
+
+	/* Reduce the limit so that only one buffer can be kept */
+	pool->set_limits (ImageBufferPool::size_class (size), 256);
+	s = pool->statistics ();
+	BOOST_CHECK_EQUAL (s.idle_buffers, 1);
+	BOOST_CHECK_EQUAL (s.frees - start.frees, 1);
+
+	pool->set_limits (1024 * 1024 * 1024, 256);
+	pool->clear ();
+	BOOST_CHECK_EQUAL (pool->statistics().idle_buffers, 0);
+}
+
+/** Check that Images of the same size re-use each other's memory */
+BOOST_AUTO_TEST_CASE (image_buffer_pool_test2)
+{
+	ImageBufferPool* pool = ImageBufferPool::instance ();
+	pool->clear ();
+
+	uint8_t* first = 0;
+	{
+		Image image (AV_PIX_FMT_RGB48LE, dcp::Size (1998, 1080), true);
+		first = image.data()[0];
+	}
+
+	ImageBufferPool::Statistics const before = pool->statistics ();
+
+	for (int i = 0; i < 16; ++i) {
+		Image image (AV_PIX_FMT_RGB48LE, dcp::Size (1998, 1080), true);
+		BOOST_CHECK (image.data()[0] == first);
+	}
+
+	ImageBufferPool::Statistics const after = pool->statistics ();
+	BOOST_CHECK_EQUAL (after.allocations, before.allocations);
+	BOOST_CHECK_EQUAL (after.reuses - before.reuses, 16);
+}
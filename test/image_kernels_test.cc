@@ -0,0 +1,467 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/** @file  test/image_kernels_test.cc
+ *  @brief Check the kernels in image_kernels.cc against straightforward
+ *  implementations, for each instruction set that this machine supports.
+ *  @ingroup selfcontained
+ */
+
+#include "lib/image_kernels.h"
+#include "lib/simd.h"
+#include <dcp/colour_conversion.h>
+#include <dcp/rgb_xyz.h>
+#include <dcp/transfer_function.h>
+#include <boost/test/unit_test.hpp>
+#include <boost/foreach.hpp>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+using std::vector;
+using std::min;
+using std::max;
+using std::abs;
+
+static vector<uint8_t>
+random_bytes (int n)
+{
+	vector<uint8_t> v (n);
+	for (int i = 0; i < n; ++i) {
+		v[i] = rand() & 0xff;
+	}
+	return v;
+}
+
+static vector<uint8_t>
+random_overlay (int pixels)
+{
+	vector<uint8_t> v = random_bytes (pixels * 4);
+	/* Make sure that we have some fully transparent and fully opaque pixels */
+	for (int i = 0; i < pixels; i += 7) {
+		v[i * 4 + 3] = (i % 2) ? 0 : 255;
+	}
+	return v;
+}
+
+/** The float blend that Image::alpha_blend used to do */
+static uint8_t
+reference_blend (uint8_t o, uint8_t t, uint8_t a)
+{
+	float const alpha = float (a) / 255;
+	return o * alpha + t * (1 - alpha);
+}
+
+static void
+check_close (uint8_t const * a, uint8_t const * b, int n, int tolerance)
+{
+	for (int i = 0; i < n; ++i) {
+		BOOST_REQUIRE_MESSAGE (abs (int (a[i]) - int (b[i])) <= tolerance, "byte " << i << ": " << int (a[i]) << " vs " << int (b[i]));
+	}
+}
+
+static void
+check_close (uint16_t const * a, uint16_t const * b, int n, int tolerance)
+{
+	for (int i = 0; i < n; ++i) {
+		BOOST_REQUIRE_MESSAGE (abs (int (a[i]) - int (b[i])) <= tolerance, "sample " << i << ": " << a[i] << " vs " << b[i]);
+	}
+}
+
+/* An odd number of pixels so that the kernels' tail handling is exercised */
+static int const pixels = 1031;
+
+BOOST_AUTO_TEST_CASE (alpha_blend_kernel_rgb24_test)
+{
+	vector<uint8_t> const overlay = random_overlay (pixels);
+	vector<uint8_t> const target = random_bytes (pixels * 3);
+
+	vector<uint8_t> reference = target;
+	for (int i = 0; i < pixels; ++i) {
+		uint8_t const * o = &overlay[i * 4];
+		uint8_t* t = &reference[i * 3];
+		t[0] = reference_blend (o[2], t[0], o[3]);
+		t[1] = reference_blend (o[1], t[1], o[3]);
+		t[2] = reference_blend (o[0], t[2], o[3]);
+	}
+
+	vector<uint8_t> none = target;
+	alpha_blend_row (AV_PIX_FMT_RGB24, &none[0], &overlay[0], pixels, SIMD_NONE);
+	check_close (&none[0], &reference[0], pixels * 3, 1);
+
+	for (int level = SIMD_SSE2; level <= simd_level_supported(); ++level) {
+		vector<uint8_t> simd = target;
+		alpha_blend_row (AV_PIX_FMT_RGB24, &simd[0], &overlay[0], pixels, static_cast<SIMDLevel> (level));
+		check_close (&simd[0], &none[0], pixels * 3, 0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE (alpha_blend_kernel_rgba_test)
+{
+	vector<uint8_t> const overlay = random_overlay (pixels);
+	vector<uint8_t> const target = random_bytes (pixels * 4);
+
+	vector<uint8_t> reference = target;
+	for (int i = 0; i < pixels; ++i) {
+		uint8_t const * o = &overlay[i * 4];
+		uint8_t* t = &reference[i * 4];
+		for (int j = 0; j < 4; ++j) {
+			t[j] = reference_blend (o[j], t[j], o[3]);
+		}
+	}
+
+	vector<uint8_t> none = target;
+	alpha_blend_row (AV_PIX_FMT_RGBA, &none[0], &overlay[0], pixels, SIMD_NONE);
+	check_close (&none[0], &reference[0], pixels * 4, 1);
+
+	for (int level = SIMD_SSE2; level <= simd_level_supported(); ++level) {
+		vector<uint8_t> simd = target;
+		alpha_blend_row (AV_PIX_FMT_BGRA, &simd[0], &overlay[0], pixels, static_cast<SIMDLevel> (level));
+		check_close (&simd[0], &none[0], pixels * 4, 0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE (alpha_blend_kernel_rgb48le_test)
+{
+	vector<uint8_t> const overlay = random_overlay (pixels);
+	vector<uint8_t> const target = random_bytes (pixels * 6);
+
+	vector<uint8_t> reference = target;
+	for (int i = 0; i < pixels; ++i) {
+		uint8_t const * o = &overlay[i * 4];
+		uint8_t* t = &reference[i * 6];
+		t[1] = reference_blend (o[2], t[1], o[3]);
+		t[3] = reference_blend (o[1], t[3], o[3]);
+		t[5] = reference_blend (o[0], t[5], o[3]);
+	}
+
+	vector<uint8_t> none = target;
+	alpha_blend_row (AV_PIX_FMT_RGB48LE, &none[0], &overlay[0], pixels, SIMD_NONE);
+	check_close (&none[0], &reference[0], pixels * 6, 1);
+
+	/* Low bytes must be untouched */
+	for (int i = 0; i < pixels * 6; i += 2) {
+		BOOST_REQUIRE_EQUAL (none[i], target[i]);
+	}
+
+	for (int level = SIMD_SSE2; level <= simd_level_supported(); ++level) {
+		vector<uint8_t> simd = target;
+		alpha_blend_row (AV_PIX_FMT_RGB48LE, &simd[0], &overlay[0], pixels, static_cast<SIMDLevel> (level));
+		check_close (&simd[0], &none[0], pixels * 6, 0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE (alpha_blend_kernel_xyz12le_test)
+{
+	vector<uint8_t> const overlay = random_overlay (pixels);
+	vector<uint16_t> target (pixels * 3);
+	for (int i = 0; i < pixels * 3; ++i) {
+		target[i] = rand() & 0xffff;
+	}
+
+	/* This is what Image::alpha_blend used to do */
+	dcp::ColourConversion conv = dcp::ColourConversion::srgb_to_xyz();
+	double fast_matrix[9];
+	dcp::combined_rgb_to_xyz (conv, fast_matrix);
+	double const * lut_in = conv.in()->lut (8, false);
+	double const * lut_out = conv.out()->lut (16, true);
+
+	vector<uint16_t> reference = target;
+	for (int i = 0; i < pixels; ++i) {
+		uint8_t const * op = &overlay[i * 4];
+		uint16_t* tp = &reference[i * 3];
+		float const alpha = float (op[3]) / 255;
+		double const r = lut_in[op[2]];
+		double const g = lut_in[op[1]];
+		double const b = lut_in[op[0]];
+		double const x = max (0.0, min (65535.0, r * fast_matrix[0] + g * fast_matrix[1] + b * fast_matrix[2]));
+		double const y = max (0.0, min (65535.0, r * fast_matrix[3] + g * fast_matrix[4] + b * fast_matrix[5]));
+		double const z = max (0.0, min (65535.0, r * fast_matrix[6] + g * fast_matrix[7] + b * fast_matrix[8]));
+		tp[0] = lrint(lut_out[lrint(x)] * 65535) * alpha + tp[0] * (1 - alpha);
+		tp[1] = lrint(lut_out[lrint(y)] * 65535) * alpha + tp[1] * (1 - alpha);
+		tp[2] = lrint(lut_out[lrint(z)] * 65535) * alpha + tp[2] * (1 - alpha);
+	}
+
+	vector<uint16_t> none = target;
+	alpha_blend_row (AV_PIX_FMT_XYZ12LE, reinterpret_cast<uint8_t*> (&none[0]), &overlay[0], pixels, SIMD_NONE);
+	check_close (&none[0], &reference[0], pixels * 3, 1);
+
+	for (int level = SIMD_SSE2; level <= simd_level_supported(); ++level) {
+		vector<uint16_t> simd = target;
+		alpha_blend_row (AV_PIX_FMT_XYZ12LE, reinterpret_cast<uint8_t*> (&simd[0]), &overlay[0], pixels, static_cast<SIMDLevel> (level));
+		check_close (&simd[0], &none[0], pixels * 3, 0);
+	}
+}
+
+static uint16_t
+swap (uint16_t v)
+{
+	return (v >> 8) | (v << 8);
+}
+
+static float const fades[] = { 0, 0.001, 0.1, 0.25, 0.5, 0.7391, 0.999, 1 };
+
+BOOST_AUTO_TEST_CASE (fade_kernel_8_test)
+{
+	vector<uint8_t> const original = random_bytes (pixels);
+
+	BOOST_FOREACH (float f, fades) {
+		/* This is what Image::fade used to do */
+		vector<uint8_t> reference = original;
+		for (int i = 0; i < pixels; ++i) {
+			reference[i] = int (float (reference[i]) * f);
+		}
+
+		vector<uint8_t> none = original;
+		fade_row_8 (&none[0], pixels, f, SIMD_NONE);
+		check_close (&none[0], &reference[0], pixels, 1);
+
+		for (int level = SIMD_SSE2; level <= simd_level_supported(); ++level) {
+			vector<uint8_t> simd = original;
+			fade_row_8 (&simd[0], pixels, f, static_cast<SIMDLevel> (level));
+			check_close (&simd[0], &none[0], pixels, 0);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE (fade_kernel_16le_test)
+{
+	vector<uint16_t> original (pixels);
+	for (int i = 0; i < pixels; ++i) {
+		original[i] = rand() & 0xffff;
+	}
+	original[0] = 65535;
+
+	BOOST_FOREACH (float f, fades) {
+		vector<uint16_t> reference = original;
+		for (int i = 0; i < pixels; ++i) {
+			reference[i] = int (float (reference[i]) * f);
+		}
+
+		vector<uint16_t> none = original;
+		fade_row_16le (&none[0], pixels, f, SIMD_NONE);
+		check_close (&none[0], &reference[0], pixels, 1);
+
+		for (int level = SIMD_SSE2; level <= simd_level_supported(); ++level) {
+			vector<uint16_t> simd = original;
+			fade_row_16le (&simd[0], pixels, f, static_cast<SIMDLevel> (level));
+			check_close (&simd[0], &none[0], pixels, 0);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE (fade_kernel_16be_test)
+{
+	vector<uint16_t> original (pixels);
+	for (int i = 0; i < pixels; ++i) {
+		original[i] = rand() & 0xffff;
+	}
+	original[0] = 65535;
+
+	BOOST_FOREACH (float f, fades) {
+		vector<uint16_t> reference = original;
+		for (int i = 0; i < pixels; ++i) {
+			reference[i] = swap (int (float (swap (reference[i])) * f));
+		}
+
+		vector<uint16_t> none = original;
+		fade_row_16be (&none[0], pixels, f, SIMD_NONE);
+
+		/* Compare in native byte order so that the tolerance makes sense */
+		vector<uint16_t> none_swapped = none;
+		vector<uint16_t> reference_swapped = reference;
+		for (int i = 0; i < pixels; ++i) {
+			none_swapped[i] = swap (none_swapped[i]);
+			reference_swapped[i] = swap (reference_swapped[i]);
+		}
+		check_close (&none_swapped[0], &reference_swapped[0], pixels, 1);
+
+		for (int level = SIMD_SSE2; level <= simd_level_supported(); ++level) {
+			vector<uint16_t> simd = original;
+			fade_row_16be (&simd[0], pixels, f, static_cast<SIMDLevel> (level));
+			check_close (&simd[0], &none[0], pixels, 0);
+		}
+	}
+}
+
+/** Check the preview XYZ to RGB conversion against a precise calculation of the
+ *  same thing; it should never be more than 1 away.
+ */
+BOOST_AUTO_TEST_CASE (xyz12le_to_rgb24_kernel_test)
+{
+	/* Every grey level, every value of X alone, and then some random colours */
+	int const count = 8192 + pixels;
+	vector<uint16_t> xyz (count * 3);
+	for (int i = 0; i < count; ++i) {
+		int const v = i & 0xfff;
+		if (i < 4096) {
+			xyz[i * 3] = xyz[i * 3 + 1] = xyz[i * 3 + 2] = v << 4;
+		} else if (i < 8192) {
+			xyz[i * 3] = v << 4;
+			xyz[i * 3 + 1] = xyz[i * 3 + 2] = 0;
+		} else {
+			for (int c = 0; c < 3; ++c) {
+				xyz[i * 3 + c] = (rand() & 0xfff) << 4;
+			}
+		}
+	}
+
+	double const matrix[9] = {
+		3.2404542, -1.5371385, -0.4985314,
+		-0.9692660, 1.8760108, 0.0415560,
+		0.0556434, -0.2040259, 1.0572252
+	};
+
+	vector<uint8_t> reference (count * 3);
+	for (int i = 0; i < count; ++i) {
+		double linear[3];
+		for (int c = 0; c < 3; ++c) {
+			linear[c] = pow ((xyz[i * 3 + c] >> 4) / 4095.0, 2.6);
+		}
+		for (int c = 0; c < 3; ++c) {
+			double const v = matrix[c * 3] * linear[0] + matrix[c * 3 + 1] * linear[1] + matrix[c * 3 + 2] * linear[2];
+			reference[i * 3 + c] = lrint (pow (max (0.0, min (1.0, v)), 1 / 2.2) * 255);
+		}
+	}
+
+	vector<uint8_t> none (count * 3);
+	xyz12le_to_rgb24_row (&xyz[0], &none[0], count, SIMD_NONE);
+	check_close (&none[0], &reference[0], count * 3, 1);
+
+	for (int level = SIMD_SSE2; level <= simd_level_supported(); ++level) {
+		vector<uint8_t> simd (count * 3);
+		xyz12le_to_rgb24_row (&xyz[0], &simd[0], count, static_cast<SIMDLevel> (level));
+		check_close (&simd[0], &none[0], count * 3, 0);
+	}
+}
+
+/** Precise conversion of one limited-range YUV pixel to 16-bit RGB */
+static void
+reference_yuv_to_rgb48 (double y, double cb, double cr, int bits, dcp::YUVToRGB yuv_to_rgb, uint16_t* rgb)
+{
+	double const kr = yuv_to_rgb == dcp::YUV_TO_RGB_REC709 ? 0.2126 : 0.299;
+	double const kb = yuv_to_rgb == dcp::YUV_TO_RGB_REC709 ? 0.0722 : 0.114;
+	double const kg = 1 - kr - kb;
+	double const shift = 1 << (bits - 8);
+
+	double const l = (y - 16 * shift) / (219 * shift);
+	double const b = (cb - 128 * shift) / (224 * shift);
+	double const r = (cr - 128 * shift) / (224 * shift);
+
+	double const out[3] = {
+		l + 2 * (1 - kr) * r,
+		l - 2 * (1 - kb) * kb * b / kg - 2 * (1 - kr) * kr * r / kg,
+		l + 2 * (1 - kb) * b
+	};
+
+	for (int c = 0; c < 3; ++c) {
+		rgb[c] = lrint (max (0.0, min (1.0, out[c])) * 65535);
+	}
+}
+
+/** @return sample (x, y) of a plane with 1 or 2 bytes per sample */
+static int
+sample (vector<uint8_t> const & plane, int stride, int bytes, int x, int y)
+{
+	if (bytes == 1) {
+		return plane[y * stride + x];
+	}
+	return reinterpret_cast<uint16_t const *> (&plane[y * stride])[x];
+}
+
+/** Check yuv_to_rgb48le against a precise conversion, with an odd crop so that
+ *  the first and last pixels of each row do not start or end a chroma pair.
+ */
+BOOST_AUTO_TEST_CASE (yuv_to_rgb48le_kernel_test)
+{
+	AVPixelFormat const formats[] = { AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P10LE, AV_PIX_FMT_YUV444P12LE };
+	int const bits[] = { 8, 10, 12 };
+	int const log2_chroma_w[] = { 1, 1, 0 };
+	int const log2_chroma_h[] = { 1, 0, 0 };
+
+	/* Wider than the kernel's chunks */
+	dcp::Size const size (603, 9);
+	int const x = 3;
+	int const y = 1;
+	dcp::Size const out_size (597, 7);
+
+	for (int f = 0; f < 3; ++f) {
+		int const bytes = bits[f] > 8 ? 2 : 1;
+		int const mask = (1 << bits[f]) - 1;
+		dcp::Size const chroma_size ((size.width + 1) >> log2_chroma_w[f], (size.height + 1) >> log2_chroma_h[f]);
+
+		/* Random planes, including values outside the limited range */
+		vector<uint8_t> planes[3];
+		int stride[3];
+		for (int c = 0; c < 3; ++c) {
+			dcp::Size const s = c == 0 ? size : chroma_size;
+			stride[c] = s.width * bytes;
+			planes[c].resize (stride[c] * s.height);
+			for (int i = 0; i < s.width * s.height; ++i) {
+				int const v = rand() & mask;
+				if (bytes == 1) {
+					planes[c][i] = v;
+				} else {
+					reinterpret_cast<uint16_t*>(&planes[c][0])[i] = v;
+				}
+			}
+		}
+
+		uint8_t const * data[3] = { &planes[0][0], &planes[1][0], &planes[2][0] };
+
+		for (int m = 0; m < dcp::YUV_TO_RGB_COUNT; ++m) {
+			dcp::YUVToRGB const yuv_to_rgb = static_cast<dcp::YUVToRGB> (m);
+
+			vector<uint16_t> reference (out_size.width * out_size.height * 3);
+			for (int j = 0; j < out_size.height; ++j) {
+				int const sy = y + j;
+				/* Chroma rows either side of sy, and the weight of the second */
+				int c0 = sy;
+				int c1 = sy;
+				double w = 0;
+				if (log2_chroma_h[f]) {
+					c0 = sy / 2;
+					c1 = max (0, min (chroma_size.height - 1, (sy & 1) ? c0 + 1 : c0 - 1));
+					w = 0.25;
+				}
+				for (int i = 0; i < out_size.width; ++i) {
+					int const sx = x + i;
+					int const cx = sx >> log2_chroma_w[f];
+					double const cb = sample (planes[1], stride[1], bytes, cx, c0) * (1 - w) + sample (planes[1], stride[1], bytes, cx, c1) * w;
+					double const cr = sample (planes[2], stride[2], bytes, cx, c0) * (1 - w) + sample (planes[2], stride[2], bytes, cx, c1) * w;
+					reference_yuv_to_rgb48 (sample (planes[0], stride[0], bytes, sx, sy), cb, cr, bits[f], yuv_to_rgb, &reference[(j * out_size.width + i) * 3]);
+				}
+			}
+
+			vector<uint16_t> none (reference.size ());
+			yuv_to_rgb48le (formats[f], yuv_to_rgb, data, stride, size, x, y, out_size, reinterpret_cast<uint8_t*> (&none[0]), out_size.width * 6, SIMD_NONE);
+			check_close (&none[0], &reference[0], none.size(), 1);
+
+			for (int level = SIMD_SSE2; level <= simd_level_supported(); ++level) {
+				vector<uint16_t> simd (reference.size ());
+				yuv_to_rgb48le (
+					formats[f], yuv_to_rgb, data, stride, size, x, y, out_size,
+					reinterpret_cast<uint8_t*> (&simd[0]), out_size.width * 6, static_cast<SIMDLevel> (level)
+					);
+				check_close (&simd[0], &none[0], simd.size(), 0);
+			}
+		}
+	}
+}
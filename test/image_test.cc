@@ -26,10 +26,16 @@
 
 #include "lib/image.h"
 #include "lib/magick_image_proxy.h"
+#include "lib/sws_context_cache.h"
+#include "lib/config.h"
 #include "test.h"
+extern "C" {
+#include <libavutil/frame.h>
+}
 #include <Magick++.h>
 #include <boost/test/unit_test.hpp>
 #include <iostream>
+#include <cmath>
 
 using std::string;
 using std::list;
@@ -188,70 +194,262 @@ BOOST_AUTO_TEST_CASE (alpha_blend_test)
 	alpha_blend_test_one (AV_PIX_FMT_YUV420P10LE, "yuv420p10le");
 }
 
-/** Test merge (list<PositionImage>) with a single image */
-BOOST_AUTO_TEST_CASE (merge_test1)
+/** Check that repeated scales with the same parameters re-use a cached SwsContext */
+BOOST_AUTO_TEST_CASE (sws_context_cache_test)
 {
-	int const stride = 48 * 4;
+	shared_ptr<Image> in (new Image (AV_PIX_FMT_YUV420P, dcp::Size (640, 480), true));
+	in->make_black ();
 
-	shared_ptr<Image> A (new Image (AV_PIX_FMT_RGBA, dcp::Size (48, 48), false));
-	A->make_transparent ();
-	uint8_t* a = A->data()[0];
+	SwsContextCache* cache = SwsContextCache::instance ();
 
-	for (int y = 0; y < 48; ++y) {
-		uint8_t* p = a + y * stride;
-		for (int x = 0; x < 16; ++x) {
-			/* red */
-			p[x * 4] = 255;
-			/* opaque */
-			p[x * 4 + 3] = 255;
-		}
+	in->crop_scale_window (Crop (), dcp::Size (320, 240), dcp::Size (320, 240), dcp::YUV_TO_RGB_REC709, AV_PIX_FMT_RGB24, true, false);
+	int const created = cache->created ();
+	int const reused = cache->reused ();
+
+	for (int i = 0; i < 16; ++i) {
+		in->crop_scale_window (Crop (), dcp::Size (320, 240), dcp::Size (320, 240), dcp::YUV_TO_RGB_REC709, AV_PIX_FMT_RGB24, true, false);
 	}
 
-	list<PositionImage> all;
-	all.push_back (PositionImage (A, Position<int> (0, 0)));
-	PositionImage merged = merge (all);
+	BOOST_CHECK_EQUAL (cache->created(), created);
+	BOOST_CHECK_EQUAL (cache->reused(), reused + 16);
 
-	BOOST_CHECK (merged.position == Position<int> (0, 0));
-	BOOST_CHECK_EQUAL (memcmp (merged.image->data()[0], A->data()[0], stride * 48), 0);
+	/* Different parameters need a new context */
+	in->scale (dcp::Size (160, 120), dcp::YUV_TO_RGB_REC709, AV_PIX_FMT_RGB24, true, false);
+	BOOST_CHECK_EQUAL (cache->created(), created + 1);
+	in->scale (dcp::Size (160, 120), dcp::YUV_TO_RGB_REC709, AV_PIX_FMT_RGB24, true, false);
+	BOOST_CHECK_EQUAL (cache->created(), created + 1);
 }
 
-/** Test merge (list<PositionImage>) with two images */
-BOOST_AUTO_TEST_CASE (merge_test2)
+static void
+fill_smooth (shared_ptr<Image> image)
 {
-	shared_ptr<Image> A (new Image (AV_PIX_FMT_RGBA, dcp::Size (48, 1), false));
-	A->make_transparent ();
-	uint8_t* a = A->data()[0];
-	for (int x = 0; x < 16; ++x) {
-		/* red */
-		a[x * 4] = 255;
-		/* opaque */
-		a[x * 4 + 3] = 255;
+	for (int c = 0; c < image->planes(); ++c) {
+		for (int y = 0; y < image->sample_size(c).height; ++y) {
+			uint8_t* p = image->data()[c] + y * image->stride()[c];
+			for (int x = 0; x < image->line_size()[c]; ++x) {
+				p[x] = lrint (128 + 100 * sin (x / 37.0 + y / 23.0 + c));
+			}
+		}
 	}
+}
+
+/** @return largest difference between corresponding samples of two images */
+static int
+max_difference (shared_ptr<const Image> a, shared_ptr<const Image> b, bool sixteen_bit)
+{
+	int diff = 0;
+	for (int c = 0; c < a->planes(); ++c) {
+		for (int y = 0; y < a->sample_size(c).height; ++y) {
+			uint8_t const * p = a->data()[c] + y * a->stride()[c];
+			uint8_t const * q = b->data()[c] + y * b->stride()[c];
+			if (sixteen_bit) {
+				uint16_t const * p16 = reinterpret_cast<uint16_t const *> (p);
+				uint16_t const * q16 = reinterpret_cast<uint16_t const *> (q);
+				for (int x = 0; x < a->line_size()[c] / 2; ++x) {
+					diff = std::max (diff, std::abs (int (p16[x]) - int (q16[x])));
+				}
+			} else {
+				for (int x = 0; x < a->line_size()[c]; ++x) {
+					diff = std::max (diff, std::abs (int (p[x]) - int (q[x])));
+				}
+			}
+		}
+	}
+	return diff;
+}
+
+/** Check that scaling in bands on several threads gives (nearly) the same result as scaling in one go */
+BOOST_AUTO_TEST_CASE (banded_scale_test)
+{
+	struct Case {
+		AVPixelFormat in_format;
+		dcp::Size in_size;
+		dcp::Size inter_size;
+		dcp::Size out_size;
+		AVPixelFormat out_format;
+		int tolerance;
+	};
+
+	Case const cases[] = {
+		/* No vertical scaling, so the result should be exactly the same */
+		{ AV_PIX_FMT_YUV422P, dcp::Size (1920, 1080), dcp::Size (1920, 1080), dcp::Size (1998, 1080), AV_PIX_FMT_RGB48LE, 0 },
+		{ AV_PIX_FMT_RGB24, dcp::Size (1998, 1080), dcp::Size (3996, 2160), dcp::Size (3996, 2160), AV_PIX_FMT_RGB24, 2 },
+		{ AV_PIX_FMT_YUV420P, dcp::Size (3840, 2160), dcp::Size (1920, 1080), dcp::Size (1998, 1080), AV_PIX_FMT_RGB48LE, 512 },
+		{ AV_PIX_FMT_YUV420P, dcp::Size (720, 576), dcp::Size (1350, 1080), dcp::Size (1998, 1080), AV_PIX_FMT_RGB24, 2 }
+	};
+
+	for (size_t i = 0; i < sizeof (cases) / sizeof (Case); ++i) {
+		Case const & c = cases[i];
+		shared_ptr<Image> in (new Image (c.in_format, c.in_size, true));
+		fill_smooth (in);
+
+		Config::instance()->set_scale_threads (1);
+		shared_ptr<Image> ref = in->crop_scale_window (Crop (), c.inter_size, c.out_size, dcp::YUV_TO_RGB_REC709, c.out_format, true, false);
+		Config::instance()->set_scale_threads (4);
+		shared_ptr<Image> banded = in->crop_scale_window (Crop (), c.inter_size, c.out_size, dcp::YUV_TO_RGB_REC709, c.out_format, true, false);
+		Config::instance()->set_scale_threads (1);
+
+		BOOST_CHECK_LE (max_difference (ref, banded, c.out_format == AV_PIX_FMT_RGB48LE), c.tolerance);
+	}
+}
+
+/** Check that the conversions that crop_scale_window does itself for some YUV formats
+ *  give nearly the same result as swscale.  The subsampled formats are only converted
+ *  this way when a fast result is asked for.
+ */
+BOOST_AUTO_TEST_CASE (yuv_to_rgb48le_test)
+{
+	AVPixelFormat const formats[] = { AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P10LE, AV_PIX_FMT_YUV444P12LE };
+	int const bits[] = { 8, 10, 12 };
+	dcp::Size const size (640, 360);
+
+	for (int f = 0; f < 3; ++f) {
+		shared_ptr<Image> in (new Image (formats[f], size, true));
+		double const shift = 1 << (bits[f] - 8);
+		for (int c = 0; c < in->planes(); ++c) {
+			for (int y = 0; y < in->sample_size(c).height; ++y) {
+				uint8_t* p = in->data()[c] + y * in->stride()[c];
+				for (int x = 0; x < in->sample_size(c).width; ++x) {
+					/* Varying luma, and chroma which changes slowly enough for the details of
+					   how it is upsampled not to matter much.
+					*/
+					double const v = c == 0 ? (16 + 219 * (0.5 + 0.5 * sin (x / 37.0 + y / 23.0))) : (128 + 40 * sin (x / 151.0 + y / 97.0 + c));
+					if (bits[f] == 8) {
+						p[x] = lrint (v);
+					} else {
+						reinterpret_cast<uint16_t*>(p)[x] = lrint (v * shift);
+					}
+				}
+			}
+		}
 
-	shared_ptr<Image> B (new Image (AV_PIX_FMT_RGBA, dcp::Size (48, 1), false));
-	B->make_transparent ();
-	uint8_t* b = B->data()[0];
-	for (int x = 0; x < 16; ++x) {
-		/* blue */
-		b[(x + 32) * 4 + 2] = 255;
-		/* opaque */
-		b[(x + 32) * 4 + 3] = 255;
+		for (int m = 0; m < dcp::YUV_TO_RGB_COUNT; ++m) {
+			dcp::YUVToRGB const yuv_to_rgb = static_cast<dcp::YUVToRGB> (m);
+			shared_ptr<Image> ours = in->crop_scale_window (Crop (), size, size, yuv_to_rgb, AV_PIX_FMT_RGB48LE, true, true);
+			shared_ptr<Image> swscale = in->scale (size, yuv_to_rgb, AV_PIX_FMT_RGB48LE, true, false);
+			/* 2 in 8 bits */
+			BOOST_CHECK_LE (max_difference (ours, swscale, true), 2 * 257);
+
+			/* A cropped conversion should give exactly the same pixels */
+			Crop crop (3, 6, 5, 2);
+			dcp::Size const cropped_size = crop.apply (size);
+			shared_ptr<Image> cropped = in->crop_scale_window (crop, cropped_size, cropped_size, yuv_to_rgb, AV_PIX_FMT_RGB48LE, true, true);
+			for (int y = 0; y < cropped_size.height; ++y) {
+				BOOST_REQUIRE_EQUAL (
+					memcmp (
+						cropped->data()[0] + y * cropped->stride()[0],
+						ours->data()[0] + (y + crop.top) * ours->stride()[0] + crop.left * 6,
+						cropped_size.width * 6
+						),
+					0
+					);
+			}
+		}
 	}
+}
 
-	list<PositionImage> all;
-	all.push_back (PositionImage (A, Position<int> (0, 0)));
-	all.push_back (PositionImage (B, Position<int> (0, 0)));
-	PositionImage merged = merge (all);
+/** Check that crop_scale_window's output for a DCP (i.e. when a fast result is not
+ *  asked for) is the same as swscale's when the chroma varies from sample to
+ *  sample, so that any difference in how it is upsampled would show.
+ */
+BOOST_AUTO_TEST_CASE (yuv_to_rgb48le_test2)
+{
+	AVPixelFormat const formats[] = { AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P10LE, AV_PIX_FMT_YUV444P12LE };
+	int const bits[] = { 8, 10, 12 };
+	dcp::Size const size (640, 360);
+
+	Config::instance()->set_scale_threads (1);
+
+	for (int f = 0; f < 3; ++f) {
+		shared_ptr<Image> in (new Image (formats[f], size, true));
+		double const shift = 1 << (bits[f] - 8);
+		for (int c = 0; c < in->planes(); ++c) {
+			for (int y = 0; y < in->sample_size(c).height; ++y) {
+				uint8_t* p = in->data()[c] + y * in->stride()[c];
+				for (int x = 0; x < in->sample_size(c).width; ++x) {
+					/* Varying luma, and chroma in a checkerboard of single samples */
+					double const v = c == 0 ? (16 + 219 * (0.5 + 0.5 * sin (x / 37.0 + y / 23.0))) : (((x + y) & 1) ? 188 : 68);
+					if (bits[f] == 8) {
+						p[x] = lrint (v);
+					} else {
+						reinterpret_cast<uint16_t*>(p)[x] = lrint (v * shift);
+					}
+				}
+			}
+		}
 
-	BOOST_CHECK (merged.position == Position<int> (0, 0));
+		shared_ptr<Image> ours = in->crop_scale_window (Crop (), size, size, dcp::YUV_TO_RGB_REC709, AV_PIX_FMT_RGB48LE, true, false);
+		shared_ptr<Image> swscale = in->scale (size, dcp::YUV_TO_RGB_REC709, AV_PIX_FMT_RGB48LE, true, false);
+		if (formats[f] == AV_PIX_FMT_YUV444P12LE) {
+			/* We convert this ourselves, but there is no upsampling so we should be close; 2 in 8 bits */
+			BOOST_CHECK_LE (max_difference (ours, swscale, true), 2 * 257);
+		} else {
+			/* swscale does these, so they should be identical */
+			BOOST_CHECK_EQUAL (max_difference (ours, swscale, true), 0);
+		}
+	}
+}
 
-	uint8_t* m = merged.image->data()[0];
+static AVFrame*
+make_frame (AVPixelFormat format, dcp::Size size)
+{
+	AVFrame* frame = av_frame_alloc ();
+	frame->width = size.width;
+	frame->height = size.height;
+	frame->format = format;
+	BOOST_REQUIRE_EQUAL (av_frame_get_buffer (frame, 32), 0);
+	for (int y = 0; y < size.height; ++y) {
+		for (int x = 0; x < size.width * 3; ++x) {
+			frame->data[0][y * frame->linesize[0] + x] = (x + y) & 0xff;
+		}
+	}
+	return frame;
+}
 
-	for (int x = 0; x < 16; ++x) {
-		BOOST_CHECK_EQUAL (m[x * 4], 255);
-		BOOST_CHECK_EQUAL (m[x * 4 + 3], 255);
-		BOOST_CHECK_EQUAL (m[(x + 16) * 4 + 3], 0);
-		BOOST_CHECK_EQUAL (m[(x + 32) * 4 + 2], 255);
-		BOOST_CHECK_EQUAL (m[(x + 32) * 4 + 3], 255);
+/** Check that an Image made from a reference-counted AVFrame uses the frame's
+ *  data, and that modifying it only copies the data when something else is
+ *  still using it.
+ */
+BOOST_AUTO_TEST_CASE (image_from_frame_test)
+{
+	dcp::Size const size (1998, 1080);
+
+	/* The frame is still in use when the Image is modified, so it must be copied */
+	AVFrame* frame = make_frame (AV_PIX_FMT_RGB24, size);
+	shared_ptr<Image> image (new Image (frame));
+	BOOST_CHECK (image->data()[0] == frame->data[0]);
+	BOOST_CHECK_EQUAL (image->stride()[0], frame->linesize[0]);
+	BOOST_CHECK_EQUAL (image->line_size()[0], size.width * 3);
+	BOOST_CHECK (image->aligned ());
+
+	image->make_black ();
+	BOOST_CHECK (image->data()[0] != frame->data[0]);
+	BOOST_CHECK_EQUAL (frame->data[0][size.width * 3 - 1], (size.width * 3 - 1) & 0xff);
+	BOOST_CHECK_EQUAL (image->data()[0][size.width * 3 - 1], 0);
+	av_frame_free (&frame);
+
+	/* Here the Image holds the only reference, so it can be modified in place */
+	frame = make_frame (AV_PIX_FMT_RGB24, size);
+	image.reset (new Image (frame));
+	uint8_t* data = frame->data[0];
+	av_frame_free (&frame);
+	image->make_black ();
+	BOOST_CHECK (image->data()[0] == data);
+	BOOST_CHECK_EQUAL (image->data()[0][size.width * 3 - 1], 0);
+
+	/* Data which isn't reference-counted must be copied straight away */
+	frame = make_frame (AV_PIX_FMT_RGB24, size);
+	AVFrame* borrowed = av_frame_alloc ();
+	borrowed->width = frame->width;
+	borrowed->height = frame->height;
+	borrowed->format = frame->format;
+	borrowed->data[0] = frame->data[0];
+	borrowed->linesize[0] = frame->linesize[0];
+	image.reset (new Image (borrowed));
+	BOOST_CHECK (image->data()[0] != frame->data[0]);
+	for (int y = 0; y < size.height; ++y) {
+		BOOST_REQUIRE_EQUAL (memcmp (image->data()[0] + y * image->stride()[0], frame->data[0] + y * frame->linesize[0], size.width * 3), 0);
 	}
+	av_frame_free (&borrowed);
+	av_frame_free (&frame);
 }
@@ -0,0 +1,124 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/** @file  test/magick_image_proxy_test.cc
+ *  @brief Check decoding of still images with MagickImageProxy.
+ *  @ingroup specific
+ */
+
+#include "lib/magick_image_proxy.h"
+#include "lib/image.h"
+#include "lib/compose.hpp"
+#include "test.h"
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <vector>
+
+using std::vector;
+using boost::shared_ptr;
+
+/** @return the value of the component c of the pixel at (x, y) in test image n */
+static uint8_t
+pixel (int n, int x, int y, int c)
+{
+	return (n * 37 + x * 3 + y * 5 + c * 101) & 0xff;
+}
+
+static boost::filesystem::path
+image_path (int n)
+{
+	return String::compose ("build/test/magick_image_proxy_test/%1.png", n);
+}
+
+static dcp::Size
+image_size (int n)
+{
+	return dcp::Size (128 + n * 7, 64 + n * 3);
+}
+
+static void
+decode (vector<shared_ptr<MagickImageProxy> > const & proxies, int first, int* errors)
+{
+	for (size_t i = 0; i < proxies.size(); ++i) {
+		/* Each thread works through the images from a different place */
+		int const n = (first + i) % proxies.size();
+		shared_ptr<Image> image = proxies[n]->image ();
+		dcp::Size const size = image_size (n);
+		if (image->size() != size) {
+			++*errors;
+			continue;
+		}
+		for (int y = 0; y < size.height; ++y) {
+			uint8_t* p = image->data()[0] + y * image->stride()[0];
+			for (int x = 0; x < size.width; ++x) {
+				for (int c = 0; c < 3; ++c) {
+					if (*p++ != pixel (n, x, y, c)) {
+						++*errors;
+					}
+				}
+			}
+		}
+	}
+}
+
+/** Decode lots of different images from lots of threads at once and check that they all come out right */
+BOOST_AUTO_TEST_CASE (magick_image_proxy_concurrency_test)
+{
+	int const images = 64;
+	int const threads = 16;
+
+	boost::filesystem::remove_all ("build/test/magick_image_proxy_test");
+	boost::filesystem::create_directories ("build/test/magick_image_proxy_test");
+
+	for (int i = 0; i < images; ++i) {
+		shared_ptr<Image> image (new Image (AV_PIX_FMT_RGB24, image_size (i), false));
+		for (int y = 0; y < image->size().height; ++y) {
+			uint8_t* p = image->data()[0] + y * image->stride()[0];
+			for (int x = 0; x < image->size().width; ++x) {
+				for (int c = 0; c < 3; ++c) {
+					*p++ = pixel (i, x, y, c);
+				}
+			}
+		}
+		write_image (image, image_path (i), "RGB");
+	}
+
+	/* Do the whole thing twice; once with fresh proxies (so that threads sometimes ask for
+	   an image that another is decoding) and once with those proxies' decoded images.
+	*/
+	vector<shared_ptr<MagickImageProxy> > proxies;
+	for (int i = 0; i < images; ++i) {
+		proxies.push_back (shared_ptr<MagickImageProxy> (new MagickImageProxy (image_path (i))));
+	}
+
+	for (int pass = 0; pass < 2; ++pass) {
+		vector<int> errors (threads, 0);
+		boost::thread_group group;
+		for (int i = 0; i < threads; ++i) {
+			group.create_thread (boost::bind (&decode, boost::cref (proxies), i * images / threads, &errors[i]));
+		}
+		group.join_all ();
+
+		for (int i = 0; i < threads; ++i) {
+			BOOST_CHECK_EQUAL (errors[i], 0);
+		}
+	}
+}
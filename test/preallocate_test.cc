@@ -0,0 +1,98 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/** @file  test/preallocate_test.cc
+ *  @brief Check the reservation of disk space for picture assets.
+ *  @ingroup specific
+ */
+
+#include "lib/film.h"
+#include "lib/image_content.h"
+#include "lib/video_content.h"
+#include "lib/dcp_content_type.h"
+#include "test.h"
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#ifdef DCPOMATIC_LINUX
+#include <sys/stat.h>
+#endif
+
+using boost::shared_ptr;
+
+/** Check that a fresh encode which cannot possibly fit on the disk fails
+ *  straight away, rather than when the disk fills up.
+ */
+BOOST_AUTO_TEST_CASE (preallocate_test1)
+{
+	shared_ptr<Film> film = new_test_film ("preallocate_test1");
+	film->set_dcp_content_type (DCPContentType::from_isdcf_name ("TST"));
+	film->set_name ("preallocate_test1");
+	film->set_j2k_bandwidth (250000000);
+	shared_ptr<ImageContent> content (new ImageContent (film, "test/data/flat_red.png"));
+	film->examine_and_add_content (content);
+	wait_for_jobs ();
+
+	/* Ten years at 250Mbit/s is about 10Pb */
+	content->video->set_length (int64_t (24) * 3600 * 24 * 365 * 10);
+	film->make_dcp ();
+	BOOST_CHECK (wait_for_jobs ());
+
+	boost::filesystem::directory_iterator i (film->internal_video_asset_dir ());
+	boost::filesystem::directory_iterator const end;
+	for (; i != end; ++i) {
+		/* Nothing should have been written */
+		BOOST_CHECK (!boost::filesystem::exists (i->path()) || boost::filesystem::file_size (i->path()) == 0);
+	}
+}
+
+/** Check that a fresh encode gives back whatever space was reserved for its
+ *  picture asset but not used.
+ */
+BOOST_AUTO_TEST_CASE (preallocate_test2)
+{
+	shared_ptr<Film> film = new_test_film ("preallocate_test2");
+	film->set_dcp_content_type (DCPContentType::from_isdcf_name ("TST"));
+	film->set_name ("preallocate_test2");
+	/* Set the bandwidth high so that the reservation will be much bigger than the
+	   (very compressible) picture data that is actually written.
+	*/
+	film->set_j2k_bandwidth (250000000);
+	shared_ptr<ImageContent> content (new ImageContent (film, "test/data/flat_red.png"));
+	film->examine_and_add_content (content);
+	wait_for_jobs ();
+
+	content->video->set_length (48);
+	film->make_dcp ();
+	BOOST_REQUIRE (!wait_for_jobs ());
+
+#ifdef DCPOMATIC_LINUX
+	boost::filesystem::directory_iterator i (film->internal_video_asset_dir ());
+	boost::filesystem::directory_iterator const end;
+	int checked = 0;
+	for (; i != end; ++i) {
+		struct stat st;
+		BOOST_REQUIRE_EQUAL (stat (i->path().c_str(), &st), 0);
+		/* Allow for a little filesystem overhead over the apparent size */
+		BOOST_CHECK (int64_t (st.st_blocks) * 512 <= st.st_size + 1024 * 1024);
+		++checked;
+	}
+	BOOST_CHECK_EQUAL (checked, 1);
+#endif
+}
@@ -30,8 +30,10 @@
 #include "lib/ffmpeg_content.h"
 #include "lib/video_content.h"
 #include "lib/ratio.h"
+#include "lib/cross.h"
 #include <dcp/mono_picture_asset.h>
 #include <dcp/stereo_picture_asset.h>
+#include <dcp/picture_asset_writer.h>
 #include <boost/test/unit_test.hpp>
 #include <iostream>
 
@@ -79,6 +81,52 @@ BOOST_AUTO_TEST_CASE (recover_test_2d)
 	BOOST_CHECK (A->equals (B, eq, boost::bind (&note, _1, _2)));
 }
 
+/** Check that the journal is written, and that recovery works when the asset has
+ *  been truncated after the last journal entry.
+ */
+BOOST_AUTO_TEST_CASE (recover_test_2d_journal)
+{
+	shared_ptr<Film> film = new_test_film ("recover_test_2d_journal");
+	film->set_dcp_content_type (DCPContentType::from_isdcf_name ("FTR"));
+	film->set_container (Ratio::from_id ("185"));
+	film->set_name ("recover_test");
+
+	shared_ptr<FFmpegContent> content (new FFmpegContent (film, "test/data/count300bd24.m2ts"));
+	film->examine_and_add_content (content);
+	wait_for_jobs ();
+
+	film->make_dcp ();
+	wait_for_jobs ();
+
+	/* 300 frames gives one journal entry, for frame 255 */
+	DCPTimePeriod const period (DCPTime (), film->length ());
+	BOOST_CHECK_EQUAL (boost::filesystem::file_size (film->journal_file (period)), 40);
+
+	boost::filesystem::path const video = "build/test/recover_test_2d_journal/video/185_2K_517799e697fdd13033f9f7e836e7dc43_24_100000000_P_S_0_1200000.mxf";
+	boost::filesystem::copy_file (
+		video,
+		"build/test/recover_test_2d_journal/original.mxf"
+		);
+
+	/* Cut the asset off a little way after the journal's frame */
+	dcp::FrameInfo info;
+	FILE* f = fopen_boost (film->info_file (period), "rb");
+	BOOST_REQUIRE (f);
+	dcpomatic_fseek (f, 270 * 48, SEEK_SET);
+	fread (&info.offset, sizeof (info.offset), 1, f);
+	fclose (f);
+	boost::filesystem::resize_file (video, info.offset + 16);
+
+	film->make_dcp ();
+	wait_for_jobs ();
+
+	shared_ptr<dcp::MonoPictureAsset> A (new dcp::MonoPictureAsset ("build/test/recover_test_2d_journal/original.mxf"));
+	shared_ptr<dcp::MonoPictureAsset> B (new dcp::MonoPictureAsset (video));
+
+	dcp::EqualityOptions eq;
+	BOOST_CHECK (A->equals (B, eq, boost::bind (&note, _1, _2)));
+}
+
 BOOST_AUTO_TEST_CASE (recover_test_3d)
 {
 	shared_ptr<Film> film = new_test_film ("recover_test_3d");
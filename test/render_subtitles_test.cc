@@ -19,13 +19,24 @@
 */
 
 /** @file  test/render_subtitles_test.cc
- *  @brief Check markup of subtitles for rendering.
+ *  @brief Check markup and rendering of subtitles.
  *  @ingroup specific
  */
 
 #include "lib/render_subtitles.h"
+#include "lib/image.h"
+#include "lib/film.h"
+#include "lib/player.h"
+#include "lib/player_video.h"
+#include "lib/text_subtitle_content.h"
+#include "lib/subtitle_content.h"
+#include "lib/cross.h"
+#include "test.h"
 #include <dcp/subtitle_string.h>
 #include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <cstdio>
 
 static void
 add (std::list<SubtitleString>& s, std::string text, bool italic, bool bold, bool underline)
@@ -108,3 +119,195 @@ BOOST_AUTO_TEST_CASE (render_markup_test6)
 	add (s, "we are bold.", false, true, false);
 	BOOST_CHECK_EQUAL (marked_up (s, 1024, 1), "<span style=\"italic\" size=\"41472\" alpha=\"65535\" color=\"#FFFFFF\">Hello</span><span size=\"41472\" alpha=\"65535\" color=\"#FFFFFF\"> world </span><span weight=\"bold\" size=\"41472\" alpha=\"65535\" color=\"#FFFFFF\">we are bold.</span>");
 }
+
+/** Check that rendering the same line again re-uses the first rendering */
+BOOST_AUTO_TEST_CASE (render_subtitles_cache_test)
+{
+	std::list<SubtitleString> s;
+	add (s, "Hello", false, false, false);
+
+	std::list<boost::shared_ptr<Font> > fonts;
+	std::list<PositionImage> a = render_subtitles (s, fonts, dcp::Size (1998, 1080), DCPTime ());
+	std::list<PositionImage> b = render_subtitles (s, fonts, dcp::Size (1998, 1080), DCPTime ());
+	BOOST_REQUIRE_EQUAL (a.size(), 1);
+	BOOST_REQUIRE_EQUAL (b.size(), 1);
+	BOOST_CHECK (a.front().image == b.front().image);
+	BOOST_CHECK (a.front().position == b.front().position);
+
+	/* A different size needs a new rendering */
+	std::list<PositionImage> c = render_subtitles (s, fonts, dcp::Size (3996, 2160), DCPTime ());
+	BOOST_REQUIRE_EQUAL (c.size(), 1);
+	BOOST_CHECK (a.front().image != c.front().image);
+
+	/* So does different text */
+	s.front().set_text ("Goodbye");
+	std::list<PositionImage> d = render_subtitles (s, fonts, dcp::Size (1998, 1080), DCPTime ());
+	BOOST_REQUIRE_EQUAL (d.size(), 1);
+	BOOST_CHECK (a.front().image != d.front().image);
+}
+
+/** Check that a rendered line's image is only as big as the text that is on it */
+BOOST_AUTO_TEST_CASE (render_subtitles_bounds_test)
+{
+	std::list<SubtitleString> s;
+	add (s, "Hi", false, false, false);
+	/* Put it 10% of the way across the frame and with its bottom 10% of the way down */
+	s.front().set_h_position (0.1);
+	s.front().set_v_position (0.1);
+
+	dcp::Size const target (3996, 2160);
+	std::list<PositionImage> images = render_subtitles (s, std::list<boost::shared_ptr<Font> > (), target, DCPTime ());
+	BOOST_REQUIRE_EQUAL (images.size(), 1);
+
+	PositionImage const & i = images.front ();
+	BOOST_CHECK (i.image->size().width < target.width / 4);
+	BOOST_CHECK (i.position.x >= target.width / 10);
+	BOOST_CHECK (i.position.x + i.image->size().width <= target.width);
+	BOOST_CHECK (i.image->size().height < target.height / 10);
+	BOOST_CHECK (i.position.y >= 0);
+}
+
+static SubtitleString
+effect_subtitle (std::string text, dcp::Effect effect, float aspect_adjust)
+{
+	return SubtitleString (
+		dcp::SubtitleString (
+			boost::optional<std::string> (),
+			false,
+			false,
+			false,
+			dcp::Colour (255, 255, 255),
+			42,
+			aspect_adjust,
+			dcp::Time (),
+			dcp::Time (),
+			0.1,
+			dcp::HALIGN_LEFT,
+			0.8,
+			dcp::VALIGN_TOP,
+			dcp::DIRECTION_LTR,
+			text,
+			effect,
+			dcp::Colour (0, 0, 255),
+			dcp::Time (),
+			dcp::Time ()
+			),
+		4
+		);
+}
+
+/** @return number of pixels which differ between a line rendered onto an image the size of its
+ *  ink and the same line rendered onto an image as wide as the frame.
+ */
+static int
+pixel_differences (PositionImage const & tight, PositionImage const & full)
+{
+	int const dx = tight.position.x - full.position.x;
+	int const dy = tight.position.y - full.position.y;
+	dcp::Size const tight_size = tight.image->size ();
+	BOOST_REQUIRE (dx >= 0);
+	BOOST_REQUIRE (dy >= 0);
+	BOOST_REQUIRE (dx + tight_size.width <= full.image->size().width);
+	BOOST_REQUIRE (dy + tight_size.height <= full.image->size().height);
+
+	int differences = 0;
+	for (int y = 0; y < full.image->size().height; ++y) {
+		uint8_t const * f = full.image->data()[0] + y * full.image->stride()[0];
+		for (int x = 0; x < full.image->size().width; ++x) {
+			bool const inside = x >= dx && x < (dx + tight_size.width) && y >= dy && y < (dy + tight_size.height);
+			uint8_t const * t = inside ? tight.image->data()[0] + (y - dy) * tight.image->stride()[0] + (x - dx) * 4 : 0;
+			for (int c = 0; c < 4; ++c) {
+				/* Anything outside the tight image must be transparent black in the full one */
+				if ((inside && f[x * 4 + c] != t[c]) || (!inside && f[x * 4 + c] != 0)) {
+					++differences;
+					break;
+				}
+			}
+		}
+	}
+
+	return differences;
+}
+
+/** Check that rendering lines onto images only as big as their ink gives the same
+ *  pixels as rendering them onto images as wide as the frame, with each effect and
+ *  with the font stretched both ways.
+ */
+BOOST_AUTO_TEST_CASE (render_subtitles_bounds_test2)
+{
+	dcp::Effect const effects[] = { dcp::NONE, dcp::BORDER, dcp::SHADOW };
+	float const aspect_adjusts[] = { 1, 0.25, 0.6, 2, 4 };
+	dcp::Size const target (1998, 1080);
+
+	for (int e = 0; e < 3; ++e) {
+		for (int a = 0; a < 5; ++a) {
+			std::list<SubtitleString> s;
+			s.push_back (effect_subtitle ("Jumping fox, quizzical wharf", effects[e], aspect_adjusts[a]));
+			std::list<boost::shared_ptr<Font> > fonts;
+
+			std::list<PositionImage> tight = render_subtitles (s, fonts, target, DCPTime ());
+			std::list<PositionImage> full = render_subtitles_full_width (s, fonts, target, DCPTime ());
+			BOOST_REQUIRE_EQUAL (tight.size(), 1);
+			BOOST_REQUIRE_EQUAL (full.size(), 1);
+			BOOST_CHECK_EQUAL (full.front().image->size().width, target.width);
+			BOOST_CHECK (tight.front().image->size().width < target.width);
+			BOOST_CHECK_EQUAL (pixel_differences (tight.front(), full.front()), 0);
+		}
+	}
+}
+
+static int prerender_expected_renders;
+static int prerender_renders_before;
+static bool prerender_waited = false;
+static bool prerender_ready = false;
+
+static void
+prerender_video (boost::shared_ptr<PlayerVideo>, DCPTime)
+{
+	if (prerender_waited) {
+		return;
+	}
+
+	/* By the time the first frame comes out the player has already seen the subtitle
+	   (which starts later); give the background thread a while to render its lines.
+	*/
+	for (int i = 0; i < 100 && rendered_line_count() < prerender_renders_before + prerender_expected_renders; ++i) {
+		boost::this_thread::sleep (boost::posix_time::milliseconds (100));
+	}
+	prerender_waited = true;
+	prerender_ready = rendered_line_count() == prerender_renders_before + prerender_expected_renders;
+}
+
+/** Check that the player renders burnt-in text subtitles in the background before they
+ *  are needed, in such a way that they need not be rendered again when they are.
+ */
+BOOST_AUTO_TEST_CASE (render_subtitles_prerender_test)
+{
+	boost::shared_ptr<Film> film = new_test_film ("render_subtitles_prerender_test");
+
+	/* One subtitle with two lines, starting a second into the film */
+	boost::filesystem::path const srt = "build/test/render_subtitles_prerender_test.srt";
+	FILE* f = fopen_boost (srt, "w");
+	BOOST_REQUIRE (f);
+	fprintf (f, "1\n00:00:01,000 --> 00:00:03,000\nRendered in the\nbackground\n\n");
+	fclose (f);
+
+	boost::shared_ptr<TextSubtitleContent> content (new TextSubtitleContent (film, srt));
+	film->examine_and_add_content (content);
+	wait_for_jobs ();
+	content->subtitle->set_use (true);
+	content->subtitle->set_burn (true);
+
+	prerender_expected_renders = 2;
+	prerender_renders_before = rendered_line_count ();
+
+	boost::shared_ptr<Player> player (new Player (film, film->playlist ()));
+	player->Video.connect (boost::bind (&prerender_video, _1, _2));
+	while (!player->pass ()) {}
+
+	BOOST_CHECK (prerender_waited);
+	/* The lines should have been rendered before their frames came along... */
+	BOOST_CHECK (prerender_ready);
+	/* ...and not rendered again when their frames were made */
+	BOOST_CHECK_EQUAL (rendered_line_count(), prerender_renders_before + prerender_expected_renders);
+}
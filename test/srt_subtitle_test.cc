@@ -29,14 +29,21 @@
 #include "lib/font.h"
 #include "lib/ratio.h"
 #include "lib/subtitle_content.h"
+#include "lib/subtitle_decoder.h"
+#include "lib/text_subtitle_decoder.h"
+#include "lib/cross.h"
+#include "lib/content_subtitle.h"
 #include "test.h"
 #include <boost/test/unit_test.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
 #include <list>
+#include <cstdio>
 
 using std::string;
 using std::list;
 using boost::shared_ptr;
+using boost::optional;
 
 /** Make a very short DCP with a single subtitle from .srt with no specified fonts */
 BOOST_AUTO_TEST_CASE (srt_subtitle_test)
@@ -173,6 +180,63 @@ BOOST_AUTO_TEST_CASE (srt_subtitle_test5)
 	check_dcp ("test/data/xml_subtitle_test2", film->dir (film->dcp_name ()));
 }
 
+static optional<string> seek_stored;
+
+static void
+store_text (ContentTextSubtitle sub)
+{
+	seek_stored = sub.subs.front().text ();
+}
+
+static optional<string>
+first_after_seek (shared_ptr<TextSubtitleDecoder> decoder, ContentTime time)
+{
+	decoder->seek (time, true);
+	seek_stored = optional<string> ();
+	while (!decoder->pass() && !seek_stored) {}
+	return seek_stored;
+}
+
+/** Check that seeking in a long .srt file starts with the right subtitle, including one
+ *  which is out of order in the file and which spans some others.
+ */
+BOOST_AUTO_TEST_CASE (srt_subtitle_seek_test)
+{
+	shared_ptr<Film> film = new_test_film ("srt_subtitle_seek_test");
+
+	boost::filesystem::path const srt = "build/test/srt_subtitle_seek_test.srt";
+	FILE* f = fopen_boost (srt, "w");
+	BOOST_REQUIRE (f);
+	for (int i = 0; i < 1000; ++i) {
+		fprintf (f, "%d\n%02d:%02d:%02d,000 --> %02d:%02d:%02d,000\nSub %d\n\n", i + 1, i * 4 / 3600, (i * 4 / 60) % 60, i * 4 % 60, i * 4 / 3600, (i * 4 / 60) % 60, i * 4 % 60 + 2, i);
+	}
+	fprintf (f, "1001\n00:00:01,000 --> 00:00:10,000\nLong\n\n");
+	fclose (f);
+
+	shared_ptr<TextSubtitleContent> content (new TextSubtitleContent (film, srt));
+	shared_ptr<TextSubtitleDecoder> decoder (new TextSubtitleDecoder (content, film->log()));
+	decoder->subtitle->TextStart.connect (bind (store_text, _1));
+
+	BOOST_CHECK_EQUAL (decoder->length().get(), ContentTime::from_seconds(3998).get());
+
+	/* Sub 500 runs from 2000s to 2002s */
+	optional<string> s = first_after_seek (decoder, ContentTime::from_seconds (2001));
+	BOOST_REQUIRE (s);
+	BOOST_CHECK_EQUAL (s.get(), "Sub 500");
+
+	/* Long is still on screen at 5s, even though Sub 0 has finished */
+	s = first_after_seek (decoder, ContentTime::from_seconds (5));
+	BOOST_REQUIRE (s);
+	BOOST_CHECK_EQUAL (s.get(), "Long");
+
+	s = first_after_seek (decoder, ContentTime::from_seconds (1));
+	BOOST_REQUIRE (s);
+	BOOST_CHECK_EQUAL (s.get(), "Sub 0");
+
+	/* Everything has finished by 3999s */
+	BOOST_CHECK (!first_after_seek (decoder, ContentTime::from_seconds (3999)));
+}
+
 #if 0
 /* XXX: this is disabled; there is some difference in font rendering
    between the test machine and others.
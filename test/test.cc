@@ -75,6 +75,7 @@ struct TestConfig
 
 		Config::instance()->set_master_encoding_threads (1);
 		Config::instance()->set_server_encoding_threads (1);
+		Config::instance()->set_scale_threads (1);
 		Config::instance()->set_server_port_base (61921);
 		Config::instance()->set_default_isdcf_metadata (ISDCFMetadata ());
 		Config::instance()->set_default_container (Ratio::from_id ("185"));
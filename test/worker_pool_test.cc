@@ -0,0 +1,72 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/** @file  test/worker_pool_test.cc
+ *  @brief Test WorkerPool.
+ *  @ingroup selfcontained
+ */
+
+#include "lib/worker_pool.h"
+#include <boost/test/unit_test.hpp>
+#include <boost/bind.hpp>
+#include <stdexcept>
+#include <vector>
+
+using std::vector;
+using std::runtime_error;
+
+static void
+set_part (vector<int>* done, int part)
+{
+	(*done)[part] += part + 1;
+}
+
+/** Check that every part is run exactly once */
+BOOST_AUTO_TEST_CASE (worker_pool_test1)
+{
+	for (int parts = 1; parts < 64; parts += 7) {
+		vector<int> done (parts, 0);
+		WorkerPool::instance()->run (parts, boost::bind (&set_part, &done, _1));
+		for (int i = 0; i < parts; ++i) {
+			BOOST_CHECK_EQUAL (done[i], i + 1);
+		}
+	}
+}
+
+static void
+throw_on_five (int part)
+{
+	if (part == 5) {
+		throw runtime_error ("part 5 failed");
+	}
+}
+
+/** Check that an exception in a part comes out of run() */
+BOOST_AUTO_TEST_CASE (worker_pool_test2)
+{
+	BOOST_CHECK_THROW (WorkerPool::instance()->run (16, boost::bind (&throw_on_five, _1)), runtime_error);
+
+	/* and that the pool still works afterwards */
+	vector<int> done (8, 0);
+	WorkerPool::instance()->run (8, boost::bind (&set_part, &done, _1));
+	for (int i = 0; i < 8; ++i) {
+		BOOST_CHECK_EQUAL (done[i], i + 1);
+	}
+}
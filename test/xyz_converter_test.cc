@@ -0,0 +1,122 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/** @file  test/xyz_converter_test.cc
+ *  @brief Check that XYZConverter gives the same results as dcp::rgb_to_xyz.
+ *  @ingroup selfcontained
+ */
+
+#include "lib/xyz_converter.h"
+#include "lib/colour_conversion.h"
+#include "lib/simd.h"
+#include <dcp/openjpeg_image.h>
+#include <dcp/rgb_xyz.h>
+#include <boost/test/unit_test.hpp>
+#include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+
+using std::vector;
+using std::min;
+using boost::shared_ptr;
+
+static int clamped_notes = 0;
+
+static void
+note (dcp::NoteType, std::string)
+{
+	++clamped_notes;
+}
+
+/** Some random pixels, plus every value that one component can take
+ *  (with the others zero or full-scale) so that the ends of the LUTs
+ *  and the clamping are exercised.
+ */
+static vector<uint16_t>
+test_pixels (int width, int height)
+{
+	vector<uint16_t> p (width * height * 3);
+	for (size_t i = 0; i < p.size(); ++i) {
+		p[i] = rand() & 0xffff;
+	}
+
+	int const n = min (width * height, 65536 * 3);
+	for (int i = 0; i < n; ++i) {
+		int const c = i / 65536;
+		p[i * 3 + 0] = c == 0 ? (i % 65536) : (c == 1 ? 0 : 65535);
+		p[i * 3 + 1] = c == 1 ? (i % 65536) : (c == 2 ? 0 : 65535);
+		p[i * 3 + 2] = c == 2 ? (i % 65536) : (c == 0 ? 0 : 65535);
+	}
+
+	return p;
+}
+
+BOOST_AUTO_TEST_CASE (xyz_converter_test)
+{
+	int const width = 1024;
+	int const height = 768;
+	vector<uint16_t> rgb = test_pixels (width, height);
+
+	BOOST_FOREACH (PresetColourConversion const & i, PresetColourConversion::all ()) {
+		clamped_notes = 0;
+		shared_ptr<dcp::OpenJPEGImage> ref = dcp::rgb_to_xyz (
+			reinterpret_cast<uint8_t const *> (&rgb[0]), dcp::Size (width, height), width * 6, i.conversion, boost::bind (&note, _1, _2)
+			);
+
+		shared_ptr<const XYZConverter> converter = XYZConverter::get (i.conversion);
+
+		for (int level = SIMD_NONE; level <= simd_level_supported(); ++level) {
+			vector<int> x (width * height);
+			vector<int> y (width * height);
+			vector<int> z (width * height);
+			int clamped = 0;
+			for (int j = 0; j < height; ++j) {
+				int const o = j * width;
+				clamped += converter->convert_row (&rgb[o * 3], width, &x[o], &y[o], &z[o], static_cast<SIMDLevel> (level));
+			}
+
+			/* dcp::rgb_to_xyz only says anything if some values were clamped */
+			BOOST_CHECK_EQUAL (clamped > 0, clamped_notes > 0);
+
+			for (int j = 0; j < width * height; ++j) {
+				BOOST_REQUIRE_EQUAL (x[j], ref->data(0)[j]);
+				BOOST_REQUIRE_EQUAL (y[j], ref->data(1)[j]);
+				BOOST_REQUIRE_EQUAL (z[j], ref->data(2)[j]);
+			}
+		}
+	}
+}
+
+/** Check that converters are shared between equal conversions */
+BOOST_AUTO_TEST_CASE (xyz_converter_cache_test)
+{
+	vector<PresetColourConversion> presets = PresetColourConversion::all ();
+	BOOST_REQUIRE (presets.size() >= 2);
+
+	shared_ptr<const XYZConverter> a = XYZConverter::get (presets[0].conversion);
+	shared_ptr<const XYZConverter> b = XYZConverter::get (presets[1].conversion);
+	BOOST_CHECK (a != b);
+	BOOST_CHECK (XYZConverter::get (presets[0].conversion) == a);
+
+	ColourConversion copy = presets[1].conversion;
+	BOOST_CHECK (XYZConverter::get (copy) == b);
+}